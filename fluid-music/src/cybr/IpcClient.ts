@@ -82,9 +82,16 @@ export class IpcClient {
     this.client = new OscIpcClient(this.config);
     this.client.once('connect', () => this.connected = true);
     this.client.on('res', (data) => {
-      const pObj = this.queue.shift();
-      try { pObj.resolve(osc.fromBuffer(data, true)); }
-      catch (err) { pObj.reject(err); this.close(); }
+      let msg;
+      try { msg = osc.fromBuffer(data, true); }
+      catch (err) { this.queue.shift().reject(err); this.close(); return; }
+      // Streamed messages (see audiotrack.streamRegion) arrive before the reply
+      // to the request that asked for them, so they must not take its place.
+      if (typeof msg.address === 'string' && msg.address.startsWith('/render/stream/')) {
+        if (this.queue.length) this.queue[0].stream(msg);
+        return;
+      }
+      this.queue.shift().resolve(msg);
     });
 
     this.client.on('close', (error) =>  {
@@ -121,8 +128,10 @@ The cybr server must be running in order for fluid-music to:
    * Send a message to the server.
    * @param msgObject Can be an osc-min object json or a Buffer
    * @param timetag See osc-min docs for details
+   * @param onStream Called with each streamed message the server sends before
+   *    its reply (for example, /render/stream/block)
    */
-  async send(msgObject : object|Buffer, timetag? : Date|number[]) {
+  async send(msgObject : object|Buffer, timetag? : Date|number[], onStream? : (msg : any) => void) {
     if (this.broken) throw new Error('FluidIpcClient: cannot send after close');
     if (!this.connectionInitiated) await this.connect();
     if (!this.connected) await this.connectPromise;
@@ -153,11 +162,18 @@ The cybr server must be running in order for fluid-music to:
         return pObj.promise;
       };
 
-      pObj.timeout = setTimeout(() => {
+      const startTimeout = () => setTimeout(() => {
         this.broken = true;
         this.rejectPendingRequest(pObj, `Request timed out after ${this.timeout} ms`);
         this.close('Request timed out');
       }, this.timeout);
+      // A streaming request is still alive as long as messages keep arriving
+      pObj.stream = (msg) => {
+        clearTimeout(pObj.timeout);
+        pObj.timeout = startTimeout();
+        if (onStream) onStream(msg);
+      };
+      pObj.timeout = startTimeout();
     });
 
     try {
@@ -1,14 +1,19 @@
-export function  report(filename) {
-  if (typeof filename !== 'string')
+/**
+ * Get a JSON report about one or more audio files (length, sample rate,
+ * channels, bit depth and format). With an array of filenames, the reply JSON
+ * is an array of reports, and the server reads the files in parallel.
+ * @param {string|string[]} filename
+ */
+export function  report(filename : string|string[]) {
+  const filenames = Array.isArray(filename) ? filename : [filename];
+  if (!filenames.length || filenames.some(name => typeof name !== 'string'))
     throw new Error('fluid.audiofile.report requires a filename string argument');
   const msg = {
     address: '/audiofile/report',
-    args: [
-      {
-        type: 'string',
-        value: filename,
-      }
-    ]
+    args: filenames.map(value => ({
+      type: 'string',
+      value,
+    })),
   }
 
   return msg;
@@ -206,6 +206,44 @@ export function renderRegion(outFilename, startTimeInWholeNotes, durationInWhole
   return { args, address: '/audiotrack/region/render' };
 }
 
+/**
+ * Like renderRegion, but instead of writing a file, the server sends the audio
+ * back over the IPC connection while it renders. Pass an `onStream` callback
+ * to `IpcClient.send` to receive the `/render/stream/begin` and
+ * `/render/stream/block` messages. The reply holds the number of frames sent.
+ * The server must be started with `--pipeline`, and stops the render with an
+ * error if the client does not read the stream for 10 seconds.
+ *
+ * @param {string} [encoding='f32'] 'f32', 's16' or 's24'
+ * @param {number} [startTimeInWholeNotes] start time in whole notes
+ * @param {number} [durationInWholeNotes] duration in whole notes
+ * @param {number} [framesPerBlock] frames per `/render/stream/block` message
+ */
+export function streamRegion(encoding = 'f32', startTimeInWholeNotes?, durationInWholeNotes?, framesPerBlock?) {
+  if (!['f32', 's16', 's24'].includes(encoding))
+    throw new Error('audiotrack.streamRegion encoding must be f32, s16 or s24');
+
+  const args : any[] = [{ type: 'string', value: encoding }];
+
+  if (startTimeInWholeNotes !== undefined || durationInWholeNotes !== undefined) {
+    if (typeof startTimeInWholeNotes !== 'number' ||
+        typeof durationInWholeNotes !== 'number')
+    {
+      const msg =
+        'An invalid time range was supplied to streamRegion: ' +
+        'Both start and duration values must be numbers.';
+      throw new Error(msg);
+    }
+    args.push({ type: 'float', value: startTimeInWholeNotes });
+    args.push({ type: 'float', value: durationInWholeNotes });
+  }
+
+  if (typeof framesPerBlock === 'number')
+    args.push({ type: 'integer', value: framesPerBlock });
+
+  return { args, address: '/audiotrack/region/stream' };
+}
+
 /**
  * Remove all clips (ex. audio, midi clips) from the selected audio track.
  */
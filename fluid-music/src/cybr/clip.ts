@@ -18,6 +18,31 @@ export function render(filename, tailInSeconds) {
   return { address: '/clip/render', args };
 };
 
+/**
+ * Stream the selected clip (audio or midi) back over the IPC connection
+ * instead of writing a file. See audiotrack.streamRegion.
+ * @param {string} [encoding='f32'] 'f32', 's16' or 's24'
+ * @param {number} [tailInSeconds] optionally render addition reverb tail
+ * @param {number} [framesPerBlock] frames per `/render/stream/block` message
+ */
+export function stream(encoding = 'f32', tailInSeconds?, framesPerBlock?) {
+  if (!['f32', 's16', 's24'].includes(encoding))
+    throw new Error('clip.stream encoding must be f32, s16 or s24');
+
+  if (tailInSeconds && typeof tailInSeconds !== 'number')
+    throw new Error('clip.stream got a non-number tailInSeconds argument');
+
+  const args : any[] = [{ type: 'string', value: encoding }];
+
+  if (typeof tailInSeconds === 'number')
+    args.push({ type: 'float', value: tailInSeconds });
+
+  if (typeof framesPerBlock === 'number')
+    args.push({ type: 'integer', value: framesPerBlock });
+
+  return { address: '/clip/stream', args };
+};
+
 /**
  * Select a clip on the currently selected track.
  * @param {string} clipName
@@ -53,3 +53,35 @@ export function activate(filename, forceEmptyEdit) {
     ],
   };
 }
+
+/**
+ * Choose how the server replies to bundles sent over this connection.
+ * Requests sent after this one use the new mode.
+ * @param {string} mode - 'full' replies to every message in the bundle,
+ *        mirroring its structure. 'errors' replies with a flat bundle
+ *        containing only the failed messages' replies. 'summary' replies with
+ *        one /bundle/summary message: the number of messages, the number of
+ *        errors, then the address and error string of the first few errors.
+ * @param {number} [maxErrors=10] - the most errors to include in a summary
+ */
+export function replyMode(mode : string, maxErrors? : number) {
+  if (['full', 'errors', 'summary'].indexOf(mode) === -1)
+    throw new Error('replyMode mode must be "full", "errors", or "summary"');
+
+  const args = [ { type: 'string', value: mode } ] as any[];
+  if (typeof maxErrors === 'number') args.push({ type: 'integer', value: maxErrors });
+
+  return { address: '/reply/mode', args };
+}
+
+/**
+ * Ask the server for a JSON report of request counts, errors, and decode,
+ * handle and encode latency for each OSC address, slowest first.
+ * @param {boolean} [reset=false] - if true, clear the metrics after reporting
+ */
+export function metricsReport(reset? : boolean) {
+  return {
+    address: '/metrics/report',
+    args: [ { type: 'integer', value: reset ? 1 : 0 } ],
+  };
+}
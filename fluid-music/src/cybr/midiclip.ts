@@ -56,6 +56,45 @@ export function note(noteNum, startTimeInWholeNotes, durationInWholeNotes=0.25,
   return { address: '/midiclip/insert/note', args }
 }
 
+/**
+ * Create a /midiclip/insert/notes message, which inserts many notes into the
+ * selected clip at once. Each column is sent as a blob of packed big-endian
+ * 32 bit values.
+ * @param {Integer[]} noteNums MIDI note numbers
+ * @param {Number[]} startTimesInWholeNotes note start times in whole notes
+ * @param {Number[]} durationsInWholeNotes note lengths in whole notes
+ * @param {Integer[]} [velocities] Optional MIDI note velocities
+ */
+export function notes(noteNums, startTimesInWholeNotes, durationsInWholeNotes, velocities?) {
+  const count = noteNums.length;
+  if (startTimesInWholeNotes.length !== count || durationsInWholeNotes.length !== count)
+    throw new Error('midiclip.notes requires columns with the same length');
+  if (velocities && velocities.length !== count)
+    throw new Error('midiclip.notes got the wrong number of velocities: ' + velocities.length);
+
+  const packInts = (values) => {
+    const buffer = Buffer.alloc(values.length * 4);
+    values.forEach((v, i) => buffer.writeInt32BE(v, i * 4));
+    return buffer;
+  };
+  const packFloats = (values) => {
+    const buffer = Buffer.alloc(values.length * 4);
+    values.forEach((v, i) => buffer.writeFloatBE(v, i * 4));
+    return buffer;
+  };
+
+  const args = [
+    { type: 'blob', value: packInts(noteNums) },
+    { type: 'blob', value: packFloats(startTimesInWholeNotes) },
+    { type: 'blob', value: packFloats(durationsInWholeNotes) },
+  ];
+
+  if (velocities)
+    args.push({ type: 'blob', value: packInts(velocities) });
+
+  return { address: '/midiclip/insert/notes', args };
+}
+
 /**
  * Build an OSC message that creates a clip with a bunch of midi notes
  * @param { string } clipName name of the clip.
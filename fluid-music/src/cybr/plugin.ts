@@ -162,6 +162,42 @@ export function setParamExplicitAt(paramName, paramValue, timeInWholeNotes=0, cu
   }
 }
 
+/**
+ * Add many automation points to a parameter of the selected plugin with a
+ * single message. Each array is sent as a blob of packed big-endian floats.
+ *
+ * @param {string} paramName - the name of the parameter
+ * @param {number[]} values - parameter values (normalized by default)
+ * @param {number[]} timesInWholeNotes - automation point times
+ * @param {number[]} [curves] - optional curve values from [-1, 1] for each
+ *    point. If omitted, all points are linear.
+ * @param {boolean} [isNormalized=true] - set false to send explicit values
+ */
+export function setParamCurve(paramName, values, timesInWholeNotes, curves?, isNormalized = true) {
+  if (typeof paramName !== 'string')
+    throw new Error('plugin.setParamCurve needs a parameterName, got: ' + paramName);
+  if (values.length !== timesInWholeNotes.length)
+    throw new Error('plugin.setParamCurve needs the same number of values and times');
+  if (curves && curves.length !== values.length)
+    throw new Error('plugin.setParamCurve got the wrong number of curve values: ' + curves.length);
+
+  const packFloats = (numbers) => {
+    const buffer = Buffer.alloc(numbers.length * 4);
+    numbers.forEach((n, i) => buffer.writeFloatBE(n, i * 4));
+    return buffer;
+  };
+
+  const args = [
+    { type: 'string', value: paramName },
+    { type: 'blob', value: packFloats(values) },
+    { type: 'blob', value: packFloats(timesInWholeNotes) },
+  ];
+  if (curves) args.push({ type: 'blob', value: packFloats(curves) });
+  args.push({ type: 'string', value: isNormalized ? 'normalized' : 'explicit' });
+
+  return { address: '/plugin/param/set/curve', args };
+}
+
 /**
  * Helper that makes plugin speciffic modules easier to write. You probably
  * do not need this unless you are writing an adapter.
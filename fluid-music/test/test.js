@@ -91,6 +91,92 @@ describe('createMidiNoteMessage', () => {
   });
 });
 
+describe('midiclip.notes', () => {
+  const msg = fluid.cybr.midiclip.notes([60, 64], [0, 0.5], [0.25, 0.125], [100, 90]);
+
+  it('should pack each column into a big-endian blob', () => {
+    msg.address.should.equal('/midiclip/insert/notes');
+    msg.args.length.should.equal(4);
+    msg.args[0].value.readInt32BE(4).should.equal(64);
+    msg.args[1].value.readFloatBE(4).should.equal(0.5);
+    msg.args[2].value.readFloatBE(0).should.equal(0.25);
+    msg.args[3].value.readInt32BE(0).should.equal(100);
+  });
+
+  it('should throw when columns have different lengths', () => {
+    should(() => { fluid.cybr.midiclip.notes([60, 64], [0], [0.25, 0.25]) }).throw();
+  });
+});
+
+describe('plugin.setParamCurve', () => {
+  it('should pack values and times into blobs', () => {
+    const msg = fluid.cybr.plugin.setParamCurve('gain', [0, 1], [0, 0.5]);
+    msg.address.should.equal('/plugin/param/set/curve');
+    msg.args[1].value.readFloatBE(4).should.equal(1);
+    msg.args[2].value.readFloatBE(4).should.equal(0.5);
+    msg.args[3].should.deepEqual({ type: 'string', value: 'normalized' });
+  });
+});
+
+describe('audiofile.report', () => {
+  it('should accept many filenames', () => {
+    const msg = fluid.cybr.audiofile.report(['a.wav', 'b.wav']);
+    msg.should.deepEqual({ address: '/audiofile/report', args: [
+      { type: 'string', value: 'a.wav' },
+      { type: 'string', value: 'b.wav' },
+    ]});
+  });
+
+  it('should throw without a filename', () => {
+    should(() => { fluid.cybr.audiofile.report([]) }).throw();
+  });
+});
+
+describe('global.replyMode', () => {
+  it('should create a /reply/mode message', () => {
+    const msg = fluid.cybr.global.replyMode('summary', 5);
+    msg.address.should.equal('/reply/mode');
+    msg.args.should.deepEqual([{ type: 'string', value: 'summary' }, { type: 'integer', value: 5 }]);
+  });
+
+  it('should throw on an unknown mode', () => {
+    should(() => { fluid.cybr.global.replyMode('some') }).throw();
+  });
+});
+
+describe('global.metricsReport', () => {
+  it('should create a /metrics/report message', () => {
+    const msg = fluid.cybr.global.metricsReport(true);
+    msg.should.deepEqual({ address: '/metrics/report', args: [{ type: 'integer', value: 1 }] });
+  });
+});
+
+describe('audiotrack.streamRegion', () => {
+  it('should create a /audiotrack/region/stream message', () => {
+    const msg = fluid.cybr.audiotrack.streamRegion('s24', 1, 2, 4096);
+    msg.address.should.equal('/audiotrack/region/stream');
+    msg.args.should.deepEqual([
+      { type: 'string', value: 's24' },
+      { type: 'float', value: 1 },
+      { type: 'float', value: 2 },
+      { type: 'integer', value: 4096 },
+    ]);
+  });
+
+  it('should throw on an unknown encoding', () => {
+    should(() => { fluid.cybr.audiotrack.streamRegion('mp3') }).throw();
+  });
+});
+
+describe('clip.stream', () => {
+  it('should create a /clip/stream message with frames per block', () => {
+    const msg = fluid.cybr.clip.stream('f32', undefined, 2048);
+    msg.should.deepEqual({ address: '/clip/stream', args: [
+      { type: 'string', value: 'f32' },
+      { type: 'integer', value: 2048 },
+    ]});
+  });
+});
 
 describe('midiclip.create', () => {
   const notes = [
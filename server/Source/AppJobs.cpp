@@ -9,23 +9,59 @@
 */
 
 #include "AppJobs.h"
+#include "CybrLog.h"
 
 using namespace juce;
 
 void AppJobs::play(CybrEdit& cybrEdit) {
-    CybrEdit* newCybrEdit = copyCybrEditForPlayback(cybrEdit);
+    const uint64 fingerprint = getStateFingerprint(cybrEdit.getEdit().state);
+    CybrEdit* newCybrEdit = takePlaybackCopy(cybrEdit, fingerprint);
     te::Edit& newEdit = newCybrEdit->getEdit();
     
     newEdit.getTransport().play(false);
     
     add(newCybrEdit);
-    Timer::callAfterDelay((int)ceil(newEdit.getLength() * 1000.), [this, newCybrEdit]() {
-        remove(newCybrEdit);
+    Timer::callAfterDelay((int)ceil(newEdit.getLength() * 1000.), [this, newCybrEdit, fingerprint]() {
+        keepWarm(newCybrEdit, fingerprint);
     });
 }
 
+CybrEdit* AppJobs::takePlaybackCopy(CybrEdit& cybrEdit, uint64 fingerprint) {
+    const double startMs = Time::getMillisecondCounterHiRes();
+    for (auto it = warmEdits.begin(); it != warmEdits.end(); ++it) {
+        if (it->fingerprint != fingerprint) continue;
+        CybrEdit* warm = it->cybrEdit.release();
+        warmEdits.erase(it);
+        warm->getEdit().getTransport().setCurrentPosition(0);
+        CYBR_LOG(info, edit, "Reused a warm playback copy in " << (Time::getMillisecondCounterHiRes() - startMs) << "ms");
+        return warm;
+    }
+
+    CybrEdit* copy = copyCybrEditForPlayback(cybrEdit);
+    CYBR_LOG(info, edit, "Created a playback copy in " << (Time::getMillisecondCounterHiRes() - startMs) << "ms");
+    return copy;
+}
+
+void AppJobs::keepWarm(CybrEdit* copy, uint64 fingerprint) {
+    if (!playingEdits.contains(copy)) return;
+
+    // Stopping and freeing the playback context leaves the plugin instances
+    // loaded, but stops the copy from using any CPU while it waits.
+    te::TransportControl& transport = copy->getEdit().getTransport();
+    transport.stop(false, false);
+    copy->releaseOscInputs();
+    transport.freePlaybackContext();
+
+    playingEdits.removeObject(copy, false);
+    warmEdits.push_back({ fingerprint, std::unique_ptr<CybrEdit>(copy) });
+    if (warmEdits.size() > maxWarmEdits) warmEdits.erase(warmEdits.begin());
+    sendChangeMessage();
+}
+
 void AppJobs::record(CybrEdit& cybrEdit) {
-    CybrEdit* newCybrEdit = copyCybrEditForPlayback(cybrEdit);
+    // Recording changes (and saves) the copy, so it is never kept warm, but
+    // it may still start from a warm copy.
+    CybrEdit* newCybrEdit = takePlaybackCopy(cybrEdit, getStateFingerprint(cybrEdit.getEdit().state));
     te::Edit& newEdit = newCybrEdit->getEdit();
 
     newEdit.getTransport().triggerClearDevicesOnStop(); // Without this, we go into an infinite loop
@@ -45,7 +81,7 @@ void AppJobs::record(CybrEdit& cybrEdit) {
     {
         if (auto oscInstance = dynamic_cast<OscInputDeviceInstance*>(i))
         {
-            std::cout << "Found OSC input: " << oscInstance->owner.getName() << std::endl;
+            CYBR_LOG(info, osc, "Found OSC input: " << oscInstance->owner.getName());
             i->setTargetTrack(*cybrHostTrack, 0, false);
             i->setRecordingEnabled(*cybrHostTrack, true); // Arm the track
             // We just set the targetTrack, However, note that a single track can have
@@ -74,6 +110,8 @@ void AppJobs::record(CybrEdit& cybrEdit) {
 
     add(newCybrEdit);
     Timer::callAfterDelay((int)ceil(newEdit.getLength() * 1000. + 1000), [this, newCybrEdit]() {
+        // triggerClearDevicesOnStop frees the playback context on stop
+        newCybrEdit->releaseOscInputs();
         newCybrEdit->getEdit().getTransport().stop(true, false);
         remove(newCybrEdit);
     });
@@ -10,6 +10,8 @@
 
 #pragma once
 #include <iostream>
+#include <memory>
+#include <vector>
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "cybr_helpers.h"
 #include "CybrEdit.h"
@@ -19,7 +21,9 @@
 namespace te = tracktion_engine;
 class AppJobs : public juce::ChangeBroadcaster {
 public:
-    /** Play the edit. This creates a NEW CybrEdit and a new te::Edit */
+    /** Play the edit. This plays a copy of the edit: either a new CybrEdit and
+     te::Edit, or a warm copy left over from an earlier play() of the same
+     state. */
     void play(CybrEdit& cybrEdit);
     void record(CybrEdit& cybrEdit);
 
@@ -38,7 +42,28 @@ public:
     FluidOscServer fluidOscServer;
     std::unique_ptr<FluidIpcServer> fluidIpcServer;
     
+    /** Delete the warm copies kept by play(), unloading their plugins. Call
+     when a different edit is activated, and before shutdown. */
+    void clearWarmEdits() { warmEdits.clear(); }
+
 private:
+    /** Get a copy of cybrEdit for playback. Creating a copy instantiates every
+     plugin, which can take seconds, so if a warm copy of identical state is
+     available, take that instead. The caller owns the result. */
+    CybrEdit* takePlaybackCopy(CybrEdit& cybrEdit, juce::uint64 fingerprint);
+    /** Stop a copy returned by takePlaybackCopy and keep it (with its plugins
+     still loaded) for the next play() of the same state */
+    void keepWarm(CybrEdit* copy, juce::uint64 fingerprint);
+
+    struct WarmEdit {
+        juce::uint64 fingerprint;
+        std::unique_ptr<CybrEdit> cybrEdit;
+    };
+    /** Each warm copy holds a full set of plugin instances, so only a few are
+     kept. Oldest first. */
+    static constexpr size_t maxWarmEdits = 2;
+    std::vector<WarmEdit> warmEdits;
+
     juce::OwnedArray<CybrEdit> playingEdits;
     bool runForever = false;
 };
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    AudioFileCache.cpp
+    Created: 16 Oct 2026 9:01:18pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "AudioFileCache.h"
+#include <atomic>
+
+using namespace juce;
+
+namespace te = tracktion_engine;
+
+namespace {
+    class PrewarmThread : public Thread {
+    public:
+        PrewarmThread(std::function<void()> work) : Thread("AudioFileCache"), work(work) {}
+        void run() override { work(); }
+    private:
+        std::function<void()> work;
+    };
+}
+
+AudioFileCache& AudioFileCache::getInstance() {
+    static AudioFileCache cache;
+    return cache;
+}
+
+AudioFileCache::Info AudioFileCache::get(const File& file) {
+    const Time modified = file.getLastModificationTime();
+    const int64 size = file.getSize();
+    Info info;
+    if (lookup(file, modified, size, info)) return info;
+
+    // Read without holding the lock, so other files can be read concurrently.
+    // If two threads miss on the same file, both read it, which is harmless.
+    info = read(file);
+    const ScopedLock sl(lock);
+    if (entries.size() >= maxEntries) entries.clear();
+    entries[file.getFullPathName()] = { modified, size, info };
+    return info;
+}
+
+bool AudioFileCache::lookup(const File& file, const Time& modified, int64 size, Info& result) {
+    const ScopedLock sl(lock);
+    auto it = entries.find(file.getFullPathName());
+    if (it != entries.end() && it->second.modified == modified && it->second.size == size) {
+        result = it->second.info;
+        return true;
+    }
+    return false;
+}
+
+AudioFileCache::Info AudioFileCache::read(const File& file) {
+    Info info;
+    std::unique_ptr<AudioFormatReader> reader(te::Engine::getInstance()
+        .getAudioFileFormatManager()
+        .readFormatManager
+        .createReaderFor(file));
+    if (reader && reader->sampleRate > 0) {
+        info.format = reader->getFormatName();
+        info.lengthSamples = reader->lengthInSamples;
+        info.sampleRate = reader->sampleRate;
+        info.numChannels = (int)reader->numChannels;
+        info.bitDepth = (int)reader->bitsPerSample;
+    }
+    return info;
+}
+
+void AudioFileCache::prewarm(const Array<File>& files, int numThreads) {
+    Array<File> toRead;
+    {
+        const ScopedLock sl(lock);
+        for (const auto& file : files) {
+            if (file == File()) continue;
+            auto it = entries.find(file.getFullPathName());
+            if (it == entries.end() || it->second.modified != file.getLastModificationTime()) toRead.addIfNotAlreadyThere(file);
+        }
+    }
+    if (toRead.isEmpty()) return;
+
+    std::atomic<int> next { 0 };
+    auto work = [this, &toRead, &next] {
+        for (int i = next++; i < toRead.size(); i = next++) get(toRead[i]);
+    };
+
+    // The calling thread reads too, so only start threads for the rest
+    OwnedArray<Thread> workers;
+    const int numWorkers = jmin(numThreads, toRead.size()) - 1;
+    for (int i = 0; i < numWorkers; i++) workers.add(new PrewarmThread(work))->startThread();
+    work();
+    for (auto worker : workers) worker->waitForThreadToExit(-1);
+}
+
+void AudioFileCache::clear() {
+    const ScopedLock sl(lock);
+    entries.clear();
+}
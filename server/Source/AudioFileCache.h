@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    AudioFileCache.h
+    Created: 16 Oct 2026 9:01:18pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <map>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/** Remembers the header information of audio files, so that a file that is
+ used many times in a session (for example a drum sample) is only opened and
+ parsed once.
+
+ Entries are keyed by path, and re-read if the file's modification time or
+ size changes. All methods are thread safe.
+ */
+class AudioFileCache {
+public:
+    struct Info {
+        bool isValid() const { return sampleRate > 0; }
+        double getLengthSeconds() const { return isValid() ? lengthSamples / sampleRate : 0; }
+
+        juce::String format;
+        juce::int64 lengthSamples = 0;
+        double sampleRate = 0;
+        int numChannels = 0;
+        int bitDepth = 0;
+    };
+
+    /** The cache shared by every FluidOscServer */
+    static AudioFileCache& getInstance();
+
+    /** Get the info for file, reading its header if it is not cached. If the
+     file cannot be read, the result is not valid. */
+    Info get(const juce::File& file);
+
+    /** Read the headers of any files that are not cached yet, using up to
+     numThreads threads (including the calling thread). Blocks until done. */
+    void prewarm(const juce::Array<juce::File>& files, int numThreads);
+
+    void clear();
+
+private:
+    struct Entry {
+        juce::Time modified;
+        juce::int64 size;
+        Info info;
+    };
+
+    bool lookup(const juce::File& file, const juce::Time& modified, juce::int64 size, Info& result);
+    static Info read(const juce::File& file);
+
+    /** Limits the memory used by sessions that reference huge sample libraries */
+    static constexpr size_t maxEntries = 20000;
+
+    juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;
+};
@@ -9,6 +9,7 @@
 */
 
 #include "CliApp.h"
+#include "CybrLog.h"
 
 #define DRIVER_CLI_OPTION "--driver"
 #define DEVICE_CLI_OPTION "--device"
@@ -27,6 +28,7 @@ void CLIApp::unhandledException(const std::exception*, const String&, int)
 
 void CLIApp::initialise(const String& commandLine)
 {
+    CybrLog::start();
     te::DeviceManager& dm     = engine.getDeviceManager();
     ArgumentList argumentList = ArgumentList(getApplicationName(), getCommandLineParameterArray());
 
@@ -128,6 +130,7 @@ void CLIApp::initialise(const String& commandLine)
     }
 
     engine.getPluginManager().createBuiltInType<OpenFrameworksPlugin>();
+    engine.getPluginManager().createBuiltInType<CybrWidthPlugin>();
     appJobs.addChangeListener(this);
     MessageManager::getInstance()->callAsync([this, argumentList] { onRunning(argumentList); });
 }
@@ -144,6 +147,21 @@ void CLIApp::shutdown()
     // needed; the Project Manager settings will be saved anyway. I'm not %100
     // sure that this is the right way to do it, but for now I'm leaving it in.
     te::getApplicationSettings()->dispatchPendingMessages();
+
+    // Unload the plugins in warm playback copies while the engine still exists
+    appJobs.clearWarmEdits();
+
+    if (options.dumpMetrics) {
+        String json = JSON::toString(OscMetrics::getInstance().getReport());
+        if (options.metricsDumpFile == File()) {
+            CybrLog::flush();
+            std::cout << json << std::endl;
+        } else if (!options.metricsDumpFile.replaceWithText(json)) {
+            std::cerr << "Failed to write metrics: " << options.metricsDumpFile.getFullPathName() << std::endl;
+        }
+    }
+    if (options.searchIndexPollMs) CybrSearchPath::stopIndexing();
+    CybrLog::stop();
 }
 
 const String CLIApp::getApplicationName()
@@ -199,7 +217,9 @@ void CLIApp::onRunning(ArgumentList argumentList)
         "Launch a server and listen for fluid engine OSC messages",
         "This runs a server that listens for OSC messages",
         [this](auto&) {
-            appJobs.fluidIpcServer = std::make_unique<FluidIpcServer>(appJobs.fluidOscServer);
+            appJobs.fluidIpcServer = std::make_unique<FluidIpcServer>(appJobs.fluidOscServer,
+                                                                       options.pipelineIpc,
+                                                                       options.ipcSessions);
             if (!appJobs.fluidIpcServer->beginWaitingForSocket(options.listenPort)) {
                 std::cout << "FluidIpcServer: failed to listen on socket" << std::endl;
                 return false;
@@ -221,6 +241,36 @@ void CLIApp::onRunning(ArgumentList argumentList)
             return true;
         } });
 
+    cApp.addCommand({
+        "--pipeline",
+        "--pipeline",
+        "Handle IPC connections with a pipeline (use before -f)",
+        "Decode incoming messages on each connection's thread, and encode and\n\
+        send replies on a separate writer thread. Edit changes still happen on\n\
+        the message thread, in the order they were received, and replies are\n\
+        always sent in request order. Long running handlers may reply\n\
+        asynchronously, and renders may be streamed to the client. Valid only\n\
+        for a subsequent -f argument.",
+        [this](auto&) {
+            options.pipelineIpc = true;
+            std::cout << "IPC pipeline enabled" << std::endl;
+        } });
+
+    cApp.addCommand({
+        "--sessions",
+        "--sessions",
+        "Give each IPC connection its own edit (use before -f)",
+        "Each client connection gets a session with its own active edit and\n\
+        its own track/clip/plugin selection, so clients do not change each\n\
+        other's edits. Implies --pipeline. An edit loaded from the command\n\
+        line is only available to UDP clients. Valid only for a subsequent\n\
+        -f argument.",
+        [this](auto&) {
+            options.pipelineIpc = true;
+            options.ipcSessions = true;
+            std::cout << "IPC sessions enabled" << std::endl;
+        } });
+
     cApp.addCommand({
         "--scan-plugins",
         "--scan-plugins", // this is printed by -h
@@ -314,6 +364,8 @@ void CLIApp::onRunning(ArgumentList argumentList)
         file. Note that the order of arguments matters.",
         [this](const ArgumentList& args) {
             auto inputFile = args.getExistingFileForOption("-i");
+            // Warm copies of the previous edit will not be played again
+            appJobs.clearWarmEdits();
             cybrEdit = std::make_unique<CybrEdit>(createEdit(inputFile, engine));
         }});
 
@@ -329,7 +381,79 @@ void CLIApp::onRunning(ArgumentList argumentList)
             auto outputFilename = args.getValueForOption("-o");
             if (outputFilename == "") outputFilename = "default-out.tracktionedit";
             auto outputFile = File::getCurrentWorkingDirectory().getChildFile(outputFilename);
-            if (cybrEdit) cybrEdit->saveActiveEdit(outputFile);
+            if (!cybrEdit) return;
+            auto& behaviour = static_cast<CybrEngineBehavior&>(engine.getEngineBehaviour());
+            behaviour.numberOfCPUsToUseForAudio = options.renderThreads;
+            cybrEdit->saveActiveEdit(outputFile, decide, options.renderBlockSize);
+        }});
+
+    cApp.addCommand({
+        "--render-block-size",
+        "--render-block-size=512",
+        "Set the block size used to render .wav files with -o",
+        "Larger blocks reduce per-block overhead when rendering offline. Valid\n\
+        only for subsequent args. Default is the audio device's block size.",
+        [this](const ArgumentList& args) {
+            String blockSizeStr = args.getValueForOption("--render-block-size");
+            int blockSize = blockSizeStr.getIntValue();
+            if (blockSize > 0) {
+                options.renderBlockSize = blockSize;
+                std::cout << "Render block size set to " << blockSize << std::endl;
+            } else {
+                std::cerr << "Invalid --render-block-size: " << blockSizeStr << std::endl;
+            }
+        } });
+
+    cApp.addCommand({
+        "--render-threads",
+        "--render-threads=4",
+        "Set the number of threads used to render .wav files with -o",
+        "Independent tracks are mixed on this many threads by the engine's\n\
+        multi-CPU mixer. --render-stems starts this many worker processes.\n\
+        Valid only for subsequent args. Default is one per CPU.",
+        [this](const ArgumentList& args) {
+            String threadsStr = args.getValueForOption("--render-threads");
+            int threads = threadsStr.getIntValue();
+            if (threads > 0) {
+                options.renderThreads = threads;
+                std::cout << "Render threads set to " << threads << std::endl;
+            } else {
+                std::cerr << "Invalid --render-threads: " << threadsStr << std::endl;
+            }
+        } });
+
+    cApp.addCommand({
+        "--render-stems",
+        "--render-stems=stems/",
+        "Render each audio track of the active Edit to its own .wav file",
+        "Files are written to the specified directory, and named after their\n\
+        tracks. The stems are rendered by several worker processes at once\n\
+        (see --render-threads). Prints progress for each stem, and the total\n\
+        wall time.",
+        [this](const ArgumentList& args) {
+            if (!cybrEdit) return;
+            auto dirname = args.getValueForOption("--render-stems");
+            if (dirname == "") dirname = "stems";
+            auto directory = File::getCurrentWorkingDirectory().getChildFile(dirname);
+            if (!directory.createDirectory()) {
+                std::cerr << "Cannot render stems: Failed to create directory: " << directory.getFullPathName() << std::endl;
+                return;
+            }
+            te::Edit& edit = cybrEdit->getEdit();
+            Array<te::Track*> tracks;
+            for (auto track : te::getAudioTracks(edit)) tracks.add(track);
+            StemRenderJob job(edit, tracks, directory, { 0, edit.getLength() }, options.renderThreads);
+            job.render();
+        }});
+
+    cApp.addCommand({
+        StemRenderJob::workerOption,
+        StemRenderJob::workerOption + "=job.json",
+        "Render stems for a --render-stems or /render/stems job",
+        "Used internally. The job file lists an edit, a time range, and the\n\
+        tracks to render. Prints one line per stem for the parent process.",
+        [this](const ArgumentList& args) {
+            StemRenderJob::runWorker(engine, File(args.getValueForOption(StemRenderJob::workerOption)));
         }});
 
     cApp.addCommand({
@@ -362,9 +486,49 @@ void CLIApp::onRunning(ArgumentList argumentList)
             auto filename = args.getValueForOption("-e");
             if (filename == "") filename = "default.tracktionedit";
             File file = File::getCurrentWorkingDirectory().getChildFile(filename);
+            appJobs.clearWarmEdits();
             cybrEdit = std::make_unique<CybrEdit>(createEmptyEdit(file, engine));
         } });
 
+    cApp.addCommand({
+        "--compact-edit",
+        "--compact-edit=song.tracktionedit",
+        "Write a binary snapshot of a .tracktionedit file, and compare load times",
+        "The snapshot is written next to the edit (song.tracktionedit.snapshot).\n\
+        /file/activate loads the snapshot instead of parsing the XML, as long as\n\
+        the .tracktionedit file's modification time and size have not changed\n\
+        since the snapshot was written. Prints the size and load time of both\n\
+        formats.",
+        [this](const ArgumentList& args) {
+            File file = args.getExistingFileForOption("--compact-edit");
+
+            EditFileStamp stamp = EditFileStamp::of(file);
+            double startMs = Time::getMillisecondCounterHiRes();
+            ValueTree xmlState = te::loadEditFromFile(engine, file, te::ProjectItemID::createNewID(0));
+            double xmlMs = Time::getMillisecondCounterHiRes() - startMs;
+
+            // Snapshot the edit exactly as /file/activate would
+            std::unique_ptr<te::Edit> edit(createEdit(file, engine, te::Edit::forEditing));
+            File snapshotFile = getEditSnapshotFile(file);
+            if (!writeEditSnapshotBinary(edit->state, snapshotFile, stamp)) {
+                std::cerr << "Failed to write snapshot: " << snapshotFile.getFullPathName() << std::endl;
+                return;
+            }
+
+            startMs = Time::getMillisecondCounterHiRes();
+            ValueTree snapshotState = readEditSnapshotBinary(snapshotFile);
+            double snapshotMs = Time::getMillisecondCounterHiRes() - startMs;
+            if (!snapshotState.isValid()) {
+                std::cerr << "Failed to read snapshot: " << snapshotFile.getFullPathName() << std::endl;
+                return;
+            }
+
+            std::cout << "Wrote: " << snapshotFile.getFullPathName() << std::endl
+                << "XML:      " << file.getSize() << " bytes, parsed in " << xmlMs << "ms" << std::endl
+                << "Snapshot: " << snapshotFile.getSize() << " bytes, read in " << snapshotMs << "ms" << std::endl;
+            if (snapshotMs > 0) std::cout << "Speedup:  " << xmlMs / snapshotMs << "x" << std::endl;
+        } });
+
     cApp.addCommand({
         "-j",
         "-j",
@@ -517,6 +681,85 @@ void CLIApp::onRunning(ArgumentList argumentList)
             }
         } });
 
+    cApp.addCommand({
+        "--log-level",
+        "--log-level=info",
+        "Set the minimum level of log messages",
+        "Log messages below this level are ignored. One of debug, info,\n\
+        warning or error. Default=info",
+        [](const ArgumentList& args) {
+            String levelName = args.getValueForOption("--log-level");
+            CybrLog::Level level;
+            if (CybrLog::parseLevel(levelName, level)) {
+                CybrLog::setLevel(level);
+            } else {
+                std::cerr << "Invalid --log-level: " << levelName << std::endl;
+            }
+        } });
+
+    cApp.addCommand({
+        "--log-rate",
+        "--log-rate=1000",
+        "Limit log messages per second",
+        "Each log category (osc, ipc, edit, ...) may log at most this many\n\
+        messages per second. Messages over the limit are counted and reported\n\
+        once per second. Errors are never suppressed. Use 0 for no limit.\n\
+        Default=1000",
+        [](const ArgumentList& args) {
+            String rateStr = args.getValueForOption("--log-rate");
+            if (rateStr.containsOnly("0123456789") && rateStr.isNotEmpty()) {
+                CybrLog::setRateLimit(rateStr.getIntValue());
+            } else {
+                std::cerr << "Invalid --log-rate: " << rateStr << std::endl;
+            }
+        } });
+
+    cApp.addCommand({
+        "--log-json",
+        "--log-json=log.jsonl",
+        "Also write log messages to a JSON lines file",
+        "Each message is appended to the file as a JSON object on its own line,\n\
+        with time (ms since epoch), level, category, thread and message keys.",
+        [](const ArgumentList& args) {
+            auto filename = args.getValueForOption("--log-json");
+            File file = File::getCurrentWorkingDirectory().getChildFile(filename);
+            if (!CybrLog::setJsonFile(file)) {
+                std::cerr << "Cannot open --log-json file: " << file.getFullPathName() << std::endl;
+            }
+        } });
+
+    cApp.addCommand({
+        "--metrics-dump",
+        "--metrics-dump[=metrics.json]",
+        "Write OSC request metrics on exit",
+        "When the app exits, write a JSON report with the number of requests,\n\
+        errors and decode/handle/encode latency percentiles for each OSC\n\
+        address, slowest first. With a filename, the report is written to that\n\
+        file. Otherwise it is printed. The same report is available from the\n\
+        /metrics/report OSC message.",
+        [this](const ArgumentList& args) {
+            options.dumpMetrics = true;
+            String filename = args.getValueForOption("--metrics-dump");
+            options.metricsDumpFile = filename.isEmpty()
+                ? File()
+                : File::getCurrentWorkingDirectory().getChildFile(filename);
+        } });
+
+    cApp.addCommand({
+        "--index-search-paths",
+        "--index-search-paths[=1000]",
+        "Keep an in-memory index of the search paths",
+        "Scan every file below the preset and sample search directories into\n\
+        memory, so that looking up samples and presets does not touch the disk.\n\
+        A background thread checks the search directories for changes every\n\
+        N milliseconds, and updates the index. Default=1000",
+        [this](const ArgumentList& args) {
+            int pollMs = args.getValueForOption("--index-search-paths").getIntValue();
+            if (pollMs <= 0) pollMs = 1000;
+            if (options.searchIndexPollMs == 0) CybrSearchPath::startIndexing(pollMs);
+            options.searchIndexPollMs = pollMs;
+        } });
+
     cApp.addCommand({
         "--ping-osc",
         "--ping-osc[=100]",
@@ -650,6 +893,8 @@ void CLIApp::onRunning(ArgumentList argumentList)
                 << std::endl << std::endl;
         } else {
             command->command(argumentList);
+            // Keep log messages ahead of output from the next command
+            CybrLog::flush();
         }
         argumentList.removeValueForOption(command->commandOption);
     }
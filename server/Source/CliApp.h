@@ -43,6 +43,14 @@ public:
 class CybrEngineBehavior : public te::EngineBehaviour {
 public:
     bool autoInitialiseDeviceManager() override { return false; }
+
+    /** The engine's mixer nodes use this many threads, for playback and for
+     offline renders. 0 uses the engine's default (one per CPU). */
+    int getNumberOfCPUsToUseForAudio() override {
+        const int n = numberOfCPUsToUseForAudio;
+        return n > 0 ? n : te::EngineBehaviour::getNumberOfCPUsToUseForAudio();
+    }
+    std::atomic<int> numberOfCPUsToUseForAudio { 0 };
 };
 
 //==============================================================================
@@ -130,6 +138,29 @@ private:
         String targetHostname { "127.0.0.1" };
         int listenPort { 9999 };
 
+        /** When enabled, the IPC server decodes and encodes messages off of
+         the message thread. See FluidIpc. */
+        bool pipelineIpc = false;
+
+        /** When enabled, each IPC connection gets its own FluidOscServer, with
+         its own active edit and selection. */
+        bool ipcSessions = false;
+
+        /** Block size for rendering .wav files with -o. See
+         MixdownRenderJob. A block size of 0 uses the device's block size. */
+        int renderBlockSize = 0;
+        /** Threads for rendering .wav files with -o. See CybrEngineBehavior.
+         0 uses one thread per CPU. */
+        int renderThreads = 0;
+
+        /** When enabled, the OSC metrics report is written on shutdown, to
+         metricsDumpFile, or to stdout if metricsDumpFile is File() */
+        bool dumpMetrics = false;
+        File metricsDumpFile;
+        /** If non-zero, the search paths are indexed (see CybrSearchIndex),
+         and checked for changes this often */
+        int searchIndexPollMs = 0;
+
         /** When helpModeFlag is enabled, the app should print the detailed command
          string instead of running the command. CLI users may set the helpModeFlag
          by specifying the -h CLI argument. */
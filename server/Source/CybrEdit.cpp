@@ -9,6 +9,8 @@
 */
 
 #include "CybrEdit.h"
+#include "CybrLog.h"
+#include "MixdownRenderJob.h"
 
 using namespace juce;
 
@@ -17,18 +19,25 @@ CybrEdit::CybrEdit(te::Edit* e) :
     state(edit->state.getOrCreateChildWithName(CYBR, nullptr))
 {
     cybrTrackList = std::make_unique<CybrTrackList>(*this, state);
-    std::cout << "CYBR sidecar to: " << edit->editFileRetriever().getFullPathName() << std::endl;
+    trackNameIndex = std::make_unique<TrackNameIndex>(*edit);
+    CYBR_LOG(info, edit, "CYBR sidecar to: " << edit->editFileRetriever().getFullPathName());
 
-    // Inside the timer callback is where messages are collected from the input
-    // device instances, and applied to the edit's ValueTree. The juce::Timer
-    // docs say that interval accuracy should be about 10-20 millisecond, which
-    // informed my on the interval. However this may be worth tweaking, depending
-    // on the volume of incoming messages.
-    startTimer(15);
+    // Messages from the input device instances are collected and applied to
+    // the edit's ValueTree as soon as the instances signal that they arrived
+    // (see handleAsyncUpdate). The inputs are found again whenever the
+    // transport changes the playback context, so the timer is only a backstop
+    // for a missed signal, and can be slow.
+    receivedOscMessages.reserve(OscInputDevice::queueCapacity);
+    edit->getTransport().addListener(this);
+    updateOscInputs();
+    startTimer(1000);
 }
 
 CybrEdit::~CybrEdit() {
-    flushPendingChanges();
+    edit->getTransport().removeListener(this);
+    // Only the inputs in the current context can still refer to this object
+    releaseOscInputs();
+    cancelPendingUpdate();
     if (saveOnClose)
         saveActiveEdit(File::getCurrentWorkingDirectory().getChildFile({ "out.tracktionedit" }));
 }
@@ -38,28 +47,84 @@ void CybrEdit::timerCallback()
     flushPendingChanges();
 }
 
+void CybrEdit::handleAsyncUpdate()
+{
+    flushPendingChanges();
+}
+
+void CybrEdit::playbackContextChanged()
+{
+    updateOscInputs();
+    // Messages may have arrived between the context starting and now
+    triggerAsyncUpdate();
+}
+
+void CybrEdit::updateOscInputs()
+{
+    oscInputs.clearQuick();
+    // Devices outlive playback contexts, so what was already reported for
+    // them is kept. The inputs are new, and their queues may even reuse the
+    // addresses of freed ones, so nothing is carried over for them.
+    std::vector<DropCounter> previousCounters;
+    previousCounters.swap(dropCounters);
+    if (!edit->getCurrentPlaybackContext()) return;
+    for (auto* instance : edit->getAllInputDevices()) {
+        if (auto* oscInput = dynamic_cast<OscInputDeviceInstance*>(instance)) {
+            oscInput->setMessageListener(this);
+            oscInputs.add(oscInput);
+            dropCounters.push_back({ &oscInput->toMessageThread, oscInput->toMessageThread.getNumDropped(), false });
+
+            const auto* deviceQueue = &oscInput->getOscInput().getIncomingMessages();
+            auto isDeviceCounter = [deviceQueue](const DropCounter& c) { return c.isDeviceQueue && c.queue == deviceQueue; };
+            if (std::any_of(dropCounters.begin(), dropCounters.end(), isDeviceCounter)) continue;
+            auto previous = std::find_if(previousCounters.begin(), previousCounters.end(), isDeviceCounter);
+            dropCounters.push_back({ deviceQueue, previous != previousCounters.end() ? previous->reported : deviceQueue->getNumDropped(), true });
+        }
+    }
+}
+
+void CybrEdit::releaseOscInputs()
+{
+    flushPendingChanges();
+    // setMessageListener waits for the audio thread to finish with the input
+    for (auto* oscInput : oscInputs) oscInput->setMessageListener(nullptr);
+    oscInputs.clearQuick();
+    // The inputs' queues are about to be freed with the context
+    dropCounters.erase(std::remove_if(dropCounters.begin(), dropCounters.end(),
+                                      [](const DropCounter& c) { return !c.isDeviceQueue; }),
+                       dropCounters.end());
+}
+
 void CybrEdit::flushPendingChanges()
 {
     // Read any received OSC messages
-    auto inputDeviceInstances = edit->getAllInputDevices();
-    for (auto* instance : inputDeviceInstances) {
-        if (auto* oscInput = dynamic_cast<OscInputDeviceInstance*>(instance)) {
-            auto* t = cybrTrackList->getOrCreateLastTrack();
-            for (auto& message : oscInput->toMessageThread.read()) {
-                t->addEvent(message.streamTime, message.value);
-            }
+    for (auto* oscInput : oscInputs) {
+        if (!oscInput->toMessageThread.read(receivedOscMessages)) continue;
+        auto* t = cybrTrackList->getOrCreateLastTrack();
+        for (auto& message : receivedOscMessages) {
+            t->addEvent(message.streamTime, message);
         }
     }
+
+    int64 dropped = 0;
+    for (auto& counter : dropCounters) {
+        const int64 total = counter.queue->getNumDropped();
+        dropped += total - counter.reported;
+        counter.reported = total;
+    }
+    if (dropped > 0) {
+        CYBR_LOG(warning, osc, "OSC input queues were full. Dropped " << dropped << " messages");
+    }
 }
 
 void CybrEdit::valueTreePropertyChanged(juce::ValueTree &treeWhosePropertyHasChanged, const juce::Identifier &property)
 {
-    std::cout << "CybrEdit property changed: " << treeWhosePropertyHasChanged.toXmlString() << std::endl;
+    CYBR_LOG(debug, edit, "CybrEdit property changed: " << treeWhosePropertyHasChanged.toXmlString());
 }
 
 void CybrEdit::valueTreeChildAdded(juce::ValueTree &parentTree, juce::ValueTree &childWhichHasBeenAdded)
 {
-    std::cout << "CybrEdit child added: " << childWhichHasBeenAdded.toXmlString() << std::endl;
+    CYBR_LOG(debug, edit, "CybrEdit child added: " << childWhichHasBeenAdded.toXmlString());
 }
 
 void CybrEdit::listClips() {
@@ -161,12 +226,12 @@ void CybrEdit::junk()
     std::cout << std::endl;
 }
 
-void CybrEdit::saveActiveEdit(File outputFile, SamplePathMode mode) {
+void CybrEdit::saveActiveEdit(File outputFile, SamplePathMode mode, int renderBlockSize) {
     auto outputExt = outputFile.getFileExtension().toLowerCase(); // resolve relative if needed
     
     if (outputExt == ".tracktionedit") {
         // Save a .tracktionedit file.
-        std::cout << "Saving: " << outputFile.getFullPathName() << std::endl;
+        CYBR_LOG(info, edit, "Saving: " << outputFile.getFullPathName());
         // When edit files are saved, prefer relative paths.
         edit->editFileRetriever = [outputFile] { return outputFile; };
         setClipAndSamplerSourcesToDirectFileReferences(*edit, mode);
@@ -176,29 +241,52 @@ void CybrEdit::saveActiveEdit(File outputFile, SamplePathMode mode) {
     }
     else if (outputExt == ".wav")
     {
-        std::cout << "Save: " << outputFile.getFullPathName() << std::endl;
-        // Just add all the tracks to the bitmask
-        BigInteger tracksToDo;
-        {
-            int trackCount = te::getAllTracks(*edit).size();
-            for (int i = 0; i < trackCount; i++) {
-                tracksToDo.setBit(i);
-            }
-        }
-        te::Renderer::renderToFile({ "Chaz Render Job" },
-                                   outputFile,
-                                   *edit,
-                                   { 0, edit->getLength() },
-                                   tracksToDo, true, {}, false);
+        CYBR_LOG(info, edit, "Save: " << outputFile.getFullPathName());
+        MixdownRenderJob job(*edit, outputFile, { 0, edit->getLength() }, renderBlockSize);
+        job.render();
     }
     else {
-        std::cout
-        << "Could not save file due to unknown extension: "
-        << outputFile.getFullPathName()
-        << std::endl;
+        CYBR_LOG(error, edit, "Could not save file due to unknown extension: "
+        << outputFile.getFullPathName());
     }
 }
 
+void CybrEdit::saveActiveEditAsync(File outputFile,
+                                   SamplePathMode mode,
+                                   ThreadPool& pool,
+                                   std::function<void(bool success)> onComplete) {
+    CYBR_LOG(info, edit, "Saving (async): " << outputFile.getFullPathName());
+    // Plugins only copy their state into the ValueTree when asked
+    edit->flushState();
+    ValueTree snapshot = edit->state.createCopy();
+    // Resolve sources against the edit's current file here, so the job does
+    // not touch the edit
+    resolveSnapshotSources(snapshot, *edit);
+
+    WeakReference<CybrEdit> self(this);
+    pool.addJob([self, snapshot, outputFile, mode, onComplete] {
+        bool success = writeEditSnapshot(snapshot, outputFile, mode);
+        if (success) {
+            // Posted before onComplete sends the reply, so the live edit is
+            // updated before the next request is handled
+            MessageManager::callAsync([self, outputFile, mode] {
+                if (CybrEdit* cybrEdit = self.get()) cybrEdit->setEditFile(outputFile, mode);
+            });
+        } else {
+            CYBR_LOG(error, edit, "Failed to save: " << outputFile.getFullPathName());
+        }
+        onComplete(success);
+    });
+}
+
+void CybrEdit::setEditFile(File editFile, SamplePathMode mode) {
+    // Make sources absolute while they still resolve against the old file,
+    // then make them relative to the new one (if mode allows)
+    setClipAndSamplerSourcesToDirectFileReferences(*edit, SamplePathMode::absolute);
+    edit->editFileRetriever = [editFile] { return editFile; };
+    setClipAndSamplerSourcesToDirectFileReferences(*edit, mode);
+}
+
 te::AudioTrack* CybrEdit::getOrCreateCybrHostAudioTrack() {
     te::AudioTrack* found = nullptr;
     edit->getTrackList().visitAllTopLevel([&found] (te::Track& t) {
@@ -211,7 +299,7 @@ te::AudioTrack* CybrEdit::getOrCreateCybrHostAudioTrack() {
         return true;
     });
     if (!found) {
-        std::cout << "No CYBR_HOST audio track found" << std::endl;
+        CYBR_LOG(warning, edit, "No CYBR_HOST audio track found");
         // We just want to add a track, and don't really care where it is.
         // I'm using insertPoint creation from Edit::ensureNumberOfAudioTracks
         te::TrackInsertPoint insertPoint(nullptr, getTopLevelTracks (*edit).getLast());
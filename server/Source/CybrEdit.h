@@ -16,6 +16,7 @@
 #include "CybrTrackList.h"
 #include "OscInputDeviceInstance.h"
 #include "SamplePathMode.h"
+#include "TrackNameIndex.h"
 
 class CybrTrackList;
 namespace te = tracktion_engine;
@@ -28,10 +29,29 @@ const juce::Identifier CYBR("CYBR");
  */
 class CybrEdit :
 public juce::ValueTree::Listener,
-private juce::Timer
+private te::TransportControl::Listener,
+private juce::Timer,
+private juce::AsyncUpdater
 {
 private:
     std::unique_ptr<te::Edit> edit;
+    /** The OSC inputs in the edit's current playback context, found by
+     updateOscInputs. The transport tells us (see playbackContextChanged)
+     whenever the context is allocated or freed, so the list is replaced
+     before any pointer into a freed context could be used. */
+    juce::Array<OscInputDeviceInstance*> oscInputs;
+    /** Reused by flushPendingChanges, so draining the inputs does not allocate */
+    std::vector<TimestampedOscMessage> receivedOscMessages;
+    /** A queue that OSC messages for this edit pass through, and how many of
+     the messages it dropped have already been reported */
+    struct DropCounter {
+        const LockFreeQueue<TimestampedOscMessage>* queue;
+        juce::int64 reported;
+        bool isDeviceQueue;
+    };
+    /** One counter for each input's queue, and one for each device's queue,
+     however many inputs share the device. Rebuilt by updateOscInputs. */
+    std::vector<DropCounter> dropCounters;
 public:
     CybrEdit(te::Edit* edit); // take ownership of the edit, and delete it when ready
     virtual ~CybrEdit();
@@ -40,16 +60,42 @@ public:
     void listClips();
     /** Print a list of all the tracks in the edit*/
     void listTracks();
-    /** Save the active edit to a .tracktionedig or .wav file */
-    void saveActiveEdit(juce::File outputFile, SamplePathMode mode = decide);
+    /** Save the active edit to a .tracktionedig or .wav file. When rendering
+     a .wav, renderBlockSize configures the MixdownRenderJob. */
+    void saveActiveEdit(juce::File outputFile,
+                        SamplePathMode mode = decide,
+                        int renderBlockSize = 0);
+    /** Save the active edit to a .tracktionedit file without blocking. The
+     state is copied on the calling thread (which must be the message thread),
+     then sample paths are rewritten and the file is written by a job on pool.
+     onComplete is called from the pool thread. The live edit is only moved to
+     outputFile (see setEditFile) if the file was written. */
+    void saveActiveEditAsync(juce::File outputFile,
+                             SamplePathMode mode,
+                             juce::ThreadPool& pool,
+                             std::function<void(bool success)> onComplete);
+    /** Point the edit at a new .tracktionedit file, and update clip and
+     sampler sources so they still find their files. Call on the message
+     thread. */
+    void setEditFile(juce::File editFile, SamplePathMode mode);
     /** List all the top level XML tags of the state */
     void listState();
     /** List all the edit's inputs. Does not create EditPlaybackContext. */
     void listInputDevices();
     /** Simple getter for the underlying edit */
     te::Edit& getEdit() { return *edit; }
+    /** Name lookup for the edit's audio and submix tracks */
+    TrackNameIndex& getTrackNameIndex() { return *trackNameIndex; }
     /** Ensure that all the most recent changes are applied to the state */
     void flushPendingChanges();
+    /** Find the OSC inputs in the edit's playback context, and ask them to
+     notify this CybrEdit when messages arrive. Called whenever the transport
+     allocates or frees a playback context. */
+    void updateOscInputs();
+    /** Apply any messages from the OSC inputs, then stop listening to them.
+     Call before freeing the playback context, so messages that are still
+     queued in it are not lost. */
+    void releaseOscInputs();
     /** Remove All Tracks with the name (case insensitive) */
     void removeTracksNamed(const juce::String name);
 
@@ -69,6 +115,11 @@ public:
     /** Check if the CybrEdit needs to be updated. This is where we retrieve incoming
      OSC messages from the OscInputDeviceInstance. */
     void timerCallback() override;
+    /** Triggered by an OscInputDeviceInstance when messages arrive */
+    void handleAsyncUpdate() override;
+    /** te::TransportControl::Listener override. The old context's inputs may
+     already be deleted, so they are forgotten without being used. */
+    void playbackContextChanged() override;
 
     // te::EditItem overrides
     juce::String getName() { return {"Cybr Edit Sidecar"}; }
@@ -76,5 +127,8 @@ public:
     // CyberEdit Member variables
     juce::ValueTree state; // type is CYBR. Immediate child of the main edit state
     std::unique_ptr<CybrTrackList> cybrTrackList;
+    std::unique_ptr<TrackNameIndex> trackNameIndex;
     bool saveOnClose = false;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(CybrEdit)
 };
@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    CybrLog.cpp
+    Created: 16 Oct 2026 8:52:08pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "CybrLog.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace juce;
+
+namespace {
+    /** One queued message. The text is truncated to fit, so that pushing a
+     message never allocates. */
+    struct Entry {
+        std::atomic<size_t> sequence { 0 };
+        CybrLog::Level level = CybrLog::info;
+        CybrLog::Category category = CybrLog::general;
+        int64 timeMs = 0;
+        uint32 threadId = 0;
+        uint16 length = 0;
+        char text[1000];
+    };
+
+    /** A bounded multi-producer queue (after Dmitry Vyukov's MPMC queue). Only
+     the writer thread pops. */
+    class EntryQueue {
+    public:
+        static constexpr size_t capacity = 1024; // must be a power of two
+
+        EntryQueue() {
+            for (size_t i = 0; i < capacity; i++) entries[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bool push(CybrLog::Level level, CybrLog::Category category, const std::string& message) {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Entry* entry;
+            for (;;) {
+                entry = &entries[pos & (capacity - 1)];
+                size_t seq = entry->sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // full
+                } else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            entry->level = level;
+            entry->category = category;
+            entry->timeMs = Time::currentTimeMillis();
+            entry->threadId = (uint32)(pointer_sized_uint)Thread::getCurrentThreadId();
+            entry->length = (uint16)jmin(message.size(), sizeof(entry->text));
+            std::memcpy(entry->text, message.data(), entry->length);
+            entry->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Returns the next entry, or nullptr. Call release() when finished. */
+        Entry* peek() {
+            Entry* entry = &entries[dequeuePos & (capacity - 1)];
+            size_t seq = entry->sequence.load(std::memory_order_acquire);
+            return seq == dequeuePos + 1 ? entry : nullptr;
+        }
+
+        void release(Entry* entry) {
+            entry->sequence.store(dequeuePos + capacity, std::memory_order_release);
+            dequeuePos++;
+        }
+
+    private:
+        Entry entries[capacity];
+        std::atomic<size_t> enqueuePos { 0 };
+        size_t dequeuePos = 0;
+    };
+
+    /** Counts messages per category in the current one second window */
+    struct RateWindow {
+        std::atomic<int64> second { 0 };
+        std::atomic<int> count { 0 };
+        std::atomic<int> suppressed { 0 };
+    };
+
+    std::atomic<int> minimumLevel { CybrLog::info };
+    std::atomic<int> rateLimit { 1000 };
+    std::atomic<int> dropped { 0 };
+    RateWindow rateWindows[CybrLog::numCategories];
+
+    void appendJsonString(std::string& out, const char* text, size_t length) {
+        out += '"';
+        for (size_t i = 0; i < length; i++) {
+            const char c = text[i];
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+                        out += escaped;
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    class LogWriter : public Thread {
+    public:
+        LogWriter() : Thread("CybrLog") {}
+        ~LogWriter() { stopThread(2000); }
+
+        void run() override {
+            while (!threadShouldExit()) {
+                drain();
+                wait(5);
+            }
+            drain();
+        }
+
+        /** Write everything in the queue. Only one thread drains at a time. */
+        void drain() {
+            const ScopedLock sl(drainLock);
+            bool wroteText = false;
+            std::string json;
+
+            while (Entry* entry = queue.peek()) {
+                std::fwrite(entry->text, 1, entry->length, stdout);
+                std::fputc('\n', stdout);
+                wroteText = true;
+                if (jsonStream) appendJsonLine(json, *entry, entry->text, entry->length);
+                queue.release(entry);
+            }
+
+            // Summaries are logged after the queue is empty, so they appear
+            // after the messages they refer to.
+            std::string summary;
+            if (int numDropped = dropped.exchange(0)) {
+                summary += "CybrLog: dropped " + std::to_string(numDropped) + " message(s) because the queue was full\n";
+            }
+            const int64 now = Time::currentTimeMillis() / 1000;
+            for (int i = 0; i < CybrLog::numCategories; i++) {
+                // Only report once the window is over, so late arrivals are counted
+                if (rateWindows[i].second.load() >= now) continue;
+                if (int numSuppressed = rateWindows[i].suppressed.exchange(0)) {
+                    summary += "CybrLog: suppressed " + std::to_string(numSuppressed) + " "
+                        + CybrLog::getCategoryName((CybrLog::Category)i) + " message(s) over the rate limit\n";
+                }
+            }
+            if (summary.size()) {
+                std::fwrite(summary.data(), 1, summary.size(), stdout);
+                wroteText = true;
+            }
+
+            if (wroteText) std::fflush(stdout);
+            if (jsonStream && json.size()) {
+                jsonStream->write(json.data(), json.size());
+                jsonStream->flush();
+            }
+        }
+
+        void appendJsonLine(std::string& json, const Entry& entry, const char* text, size_t length) {
+            json += "{\"time\":" + std::to_string(entry.timeMs);
+            json += ",\"level\":\"";
+            json += CybrLog::getLevelName(entry.level);
+            json += "\",\"category\":\"";
+            json += CybrLog::getCategoryName(entry.category);
+            json += "\",\"thread\":" + std::to_string(entry.threadId);
+            json += ",\"message\":";
+            appendJsonString(json, text, length);
+            json += "}\n";
+        }
+
+        EntryQueue queue;
+        CriticalSection drainLock;
+        std::unique_ptr<FileOutputStream> jsonStream;
+    };
+
+    LogWriter& getWriter() {
+        static LogWriter writer;
+        return writer;
+    }
+}
+
+void CybrLog::start() {
+    getWriter().startThread();
+}
+
+void CybrLog::stop() {
+    getWriter().stopThread(2000);
+    getWriter().drain();
+}
+
+void CybrLog::flush() {
+    getWriter().drain();
+}
+
+bool CybrLog::shouldLog(Level level, Category category) {
+    if (level < minimumLevel.load(std::memory_order_relaxed)) return false;
+    const int limit = rateLimit.load(std::memory_order_relaxed);
+    if (limit <= 0 || level >= error) return true; // errors are never suppressed
+
+    RateWindow& window = rateWindows[category];
+    const int64 now = Time::currentTimeMillis() / 1000;
+    int64 second = window.second.load(std::memory_order_relaxed);
+    if (second != now && window.second.compare_exchange_strong(second, now)) {
+        window.count.store(0);
+    }
+    if (window.count.fetch_add(1) < limit) return true;
+    window.suppressed.fetch_add(1);
+    return false;
+}
+
+void CybrLog::write(Level level, Category category, const std::string& message) {
+    LogWriter& writer = getWriter();
+    if (!writer.isThreadRunning()) {
+        // Not started (or already stopped): write synchronously, after
+        // anything still in the queue.
+        const ScopedLock sl(writer.drainLock);
+        writer.drain();
+        Entry entry;
+        entry.level = level;
+        entry.category = category;
+        entry.timeMs = Time::currentTimeMillis();
+        entry.threadId = (uint32)(pointer_sized_uint)Thread::getCurrentThreadId();
+        std::fwrite(message.data(), 1, message.size(), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+        if (writer.jsonStream) {
+            std::string json;
+            writer.appendJsonLine(json, entry, message.data(), message.size());
+            writer.jsonStream->write(json.data(), json.size());
+            writer.jsonStream->flush();
+        }
+        return;
+    }
+    if (!writer.queue.push(level, category, message)) dropped.fetch_add(1);
+}
+
+void CybrLog::setLevel(Level level) { minimumLevel = level; }
+CybrLog::Level CybrLog::getLevel() { return (Level)minimumLevel.load(); }
+void CybrLog::setRateLimit(int messagesPerSecond) { rateLimit = messagesPerSecond; }
+int CybrLog::getRateLimit() { return rateLimit.load(); }
+
+bool CybrLog::setJsonFile(const File& file) {
+    LogWriter& writer = getWriter();
+    const ScopedLock sl(writer.drainLock);
+    writer.jsonStream.reset();
+    if (file == File()) return true;
+
+    auto stream = std::make_unique<FileOutputStream>(file);
+    if (stream->failedToOpen()) return false;
+    writer.jsonStream = std::move(stream);
+    return true;
+}
+
+bool CybrLog::parseLevel(const String& name, Level& result) {
+    for (int i = 0; i < numLevels; i++) {
+        if (name.equalsIgnoreCase(getLevelName((Level)i))) {
+            result = (Level)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* CybrLog::getLevelName(Level level) {
+    switch (level) {
+        case debug:   return "debug";
+        case info:    return "info";
+        case warning: return "warning";
+        case error:   return "error";
+        default:      return "unknown";
+    }
+}
+
+const char* CybrLog::getCategoryName(Category category) {
+    switch (category) {
+        case general: return "general";
+        case osc:     return "osc";
+        case ipc:     return "ipc";
+        case edit:    return "edit";
+        case plugin:  return "plugin";
+        case render:  return "render";
+        case files:   return "files";
+        case audio:   return "audio";
+        default:      return "unknown";
+    }
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    CybrLog.h
+    Created: 16 Oct 2026 8:52:08pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <sstream>
+#include <string>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/** Log a message without blocking the calling thread. For example:
+
+ CYBR_LOG(error, osc, "Plugin not found: " << name);
+
+ The first argument is a CybrLog::Level, and the second is a CybrLog::Category.
+ The message is formatted with std::ostream operators, but only if the level is
+ enabled and the category is not over its rate limit.
+ */
+#define CYBR_LOG(level, category, message) \
+    do { \
+        if (CybrLog::shouldLog(CybrLog::level, CybrLog::category)) { \
+            std::ostringstream cybrLogStream; \
+            cybrLogStream << message; \
+            CybrLog::write(CybrLog::level, CybrLog::category, cybrLogStream.str()); \
+        } \
+    } while (false)
+
+/** Asynchronous logging.
+
+ Messages from any thread (including the audio thread) are pushed onto a
+ lock-free queue, and a background thread writes them to stdout and, if
+ configured, to a JSON lines file. If the queue is full, messages are dropped
+ and counted rather than blocking the caller.
+
+ Each category may log at most getRateLimit() messages per second. Messages
+ over the limit are counted, and the count is logged once per second.
+
+ Until start() is called, and after stop(), messages are written immediately
+ on the calling thread.
+ */
+class CybrLog {
+public:
+    enum Level { debug, info, warning, error, numLevels };
+    enum Category { general, osc, ipc, edit, plugin, render, files, audio, numCategories };
+
+    static void start();
+    /** Write everything in the queue, and stop the background thread */
+    static void stop();
+    /** Block until everything logged so far has been written */
+    static void flush();
+
+    static bool shouldLog(Level level, Category category);
+    static void write(Level level, Category category, const std::string& message);
+
+    static void setLevel(Level level);
+    static Level getLevel();
+    /** Messages per second per category. 0 means no limit. */
+    static void setRateLimit(int messagesPerSecond);
+    static int getRateLimit();
+    /** Also write each message as a line of JSON to file. Pass File() to stop. */
+    static bool setJsonFile(const juce::File& file);
+
+    /** Parse "debug", "info", "warning" or "error". Returns false if the string
+     is not a level name. */
+    static bool parseLevel(const juce::String& name, Level& result);
+    static const char* getLevelName(Level level);
+    static const char* getCategoryName(Category category);
+};
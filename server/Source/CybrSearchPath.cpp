@@ -9,9 +9,16 @@
 */
 
 #include "CybrSearchPath.h"
+#include "CybrLog.h"
+#include <map>
 
 using namespace juce;
 
+namespace {
+    SpinLock indexesLock;
+    std::map<String, std::shared_ptr<CybrSearchIndex>> indexes;
+}
+
 File getWaveformAppDir() {
     PropertiesFile::Options jucePropOpts;
 
@@ -91,6 +98,14 @@ Array<File> CybrSearchPath::paths() const {
 }
 
 File CybrSearchPath::find(const StringRef filePath) const {
+    // When indexing is enabled, most lookups are answered from memory. Paths
+    // the index does not have (for example files created since the last scan)
+    // are still checked on disk.
+    if (auto index = getIndex(name)) {
+        File result;
+        if (index->find(filePath, result)) return result;
+    }
+
     auto dirs = paths();
 
     for (auto dir : dirs) {
@@ -101,3 +116,170 @@ File CybrSearchPath::find(const StringRef filePath) const {
     }
     return File();
 }
+
+void CybrSearchPath::startIndexing(int pollIntervalMs) {
+    for (auto name : { CYBR_PRESET, CYBR_SAMPLE }) {
+        auto index = std::make_shared<CybrSearchIndex>(CybrSearchPath(name).key(), pollIntervalMs);
+        const SpinLock::ScopedLockType sl(indexesLock);
+        indexes[name].swap(index);
+    }
+}
+
+void CybrSearchPath::stopIndexing() {
+    std::map<String, std::shared_ptr<CybrSearchIndex>> stopping;
+    {
+        const SpinLock::ScopedLockType sl(indexesLock);
+        stopping.swap(indexes);
+    }
+    // The index threads are stopped here, outside of the lock
+}
+
+std::shared_ptr<CybrSearchIndex> CybrSearchPath::getIndex(const String& name) {
+    const SpinLock::ScopedLockType sl(indexesLock);
+    auto it = indexes.find(name);
+    return it == indexes.end() ? nullptr : it->second;
+}
+
+//==============================================================================
+CybrSearchIndex::CybrSearchIndex(const String& settingsKey, int pollIntervalMs)
+: Thread("CybrSearchIndex"), settingsKey(settingsKey), pollIntervalMs(jmax(10, pollIntervalMs)) {
+    startThread(3);
+}
+
+CybrSearchIndex::~CybrSearchIndex() {
+    stopThread(10000);
+}
+
+bool CybrSearchIndex::find(StringRef filePath, File& result) const {
+    uint64 hash;
+    if (!hashRelativePath(filePath, hash)) return false;
+
+    std::shared_ptr<const Index> current;
+    {
+        const SpinLock::ScopedLockType sl(indexLock);
+        current = index;
+    }
+    if (!current) return false;
+
+    // There is one entry per relative path (see scan), so the first match is
+    // the only match.
+    auto range = current->files.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (isSamePath(filePath, it->second.relativePath)) {
+            result = it->second.file;
+            return true;
+        }
+    }
+    return false;
+}
+
+int CybrSearchIndex::getNumFiles() const {
+    const SpinLock::ScopedLockType sl(indexLock);
+    return index ? (int)index->files.size() : -1;
+}
+
+void CybrSearchIndex::run() {
+    while (!threadShouldExit()) {
+        std::shared_ptr<const Index> current;
+        {
+            const SpinLock::ScopedLockType sl(indexLock);
+            current = index;
+        }
+
+        const String pathString = te::getApplicationSettings()->getValue(settingsKey);
+        if (!current || isStale(*current, pathString)) {
+            const double startMs = Time::getMillisecondCounterHiRes();
+            auto updated = scan(pathString);
+            if (!updated) return; // the thread is stopping
+            CYBR_LOG(debug, files, "Indexed " << (int)updated->files.size() << " files in "
+                << updated->directories.size() << " directories for " << settingsKey << " in "
+                << (Time::getMillisecondCounterHiRes() - startMs) << "ms");
+            const SpinLock::ScopedLockType sl(indexLock);
+            index = updated;
+        }
+        wait(pollIntervalMs);
+    }
+}
+
+bool CybrSearchIndex::isStale(const Index& current, const String& pathString) const {
+    if (current.pathString != pathString) return true;
+    // Adding, removing or renaming a file changes the modification time of
+    // its directory.
+    for (int i = 0; i < current.directories.size(); i++) {
+        if (current.directories.getReference(i).getLastModificationTime() != current.modified.getReference(i))
+            return true;
+    }
+    return false;
+}
+
+std::shared_ptr<const CybrSearchIndex::Index> CybrSearchIndex::scan(const String& pathString) {
+    auto updated = std::make_shared<Index>();
+    updated->pathString = pathString;
+
+    FileSearchPath searchPath(pathString);
+    for (int i = 0; i < searchPath.getNumPaths(); i++) {
+        const File root = searchPath[i];
+        updated->directories.add(root);
+        updated->modified.add(root.getLastModificationTime());
+
+        DirectoryIterator iter(root, true, "*", File::findFilesAndDirectories);
+        bool isDirectory;
+        Time modified;
+        while (iter.next(&isDirectory, nullptr, nullptr, &modified, nullptr, nullptr)) {
+            if (Thread::currentThreadShouldExit()) return nullptr;
+            const File file = iter.getFile();
+            if (isDirectory) {
+                updated->directories.add(file);
+                updated->modified.add(modified);
+                continue;
+            }
+            const String relativePath = file.getRelativePathFrom(root).replaceCharacter('\\', '/');
+            uint64 hash;
+            if (!hashRelativePath(relativePath, hash)) continue;
+            // The order of equal keys in an unordered_multimap is unspecified,
+            // so keep only the first directory's file for each path, like
+            // CybrSearchPath::find. Different paths may share a hash.
+            bool found = false;
+            auto range = updated->files.equal_range(hash);
+            for (auto it = range.first; it != range.second && !found; ++it) {
+                found = it->second.relativePath == relativePath;
+            }
+            if (!found) updated->files.insert({ hash, { relativePath, file } });
+        }
+    }
+    return updated;
+}
+
+bool CybrSearchIndex::hashRelativePath(StringRef path, uint64& hash) {
+    // 64 bit FNV-1a, with a check for "." and ".." segments along the way
+    auto p = path.text;
+    if (*p == '/' || *p == '\\' || *p == '~') return false;
+    hash = 14695981039346656037ULL;
+    int segmentLength = 0;
+    int segmentDots = 0;
+    for (juce_wchar c = p.getAndAdvance(); c != 0; c = p.getAndAdvance()) {
+        if (c == '\\') c = '/';
+        if (c == ':') return false; // A windows drive letter
+        if (c == '/') {
+            if (segmentLength == segmentDots && segmentLength <= 2) return false;
+            segmentLength = segmentDots = 0;
+        } else {
+            segmentLength++;
+            if (c == '.') segmentDots++;
+        }
+        hash = (hash ^ (uint64)c) * 1099511628211ULL;
+    }
+    return !(segmentLength == segmentDots && segmentLength <= 2);
+}
+
+bool CybrSearchIndex::isSamePath(StringRef path, const String& relativePath) {
+    auto a = path.text;
+    auto b = relativePath.getCharPointer();
+    for (;;) {
+        juce_wchar ca = a.getAndAdvance();
+        const juce_wchar cb = b.getAndAdvance();
+        if (ca == '\\') ca = '/';
+        if (ca != cb) return false;
+        if (ca == 0) return true;
+    }
+}
@@ -11,6 +11,8 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 #include "../JuceLibraryCode/JuceHeader.h"
 
 namespace te = tracktion_engine;
@@ -21,6 +23,55 @@ const juce::String CYBR_SAMPLE("sample");
 /** Guess the application directory for Tracktion Waveform */
 juce::File getWaveformAppDir();
 
+/** An in-memory map from relative path to file, covering every file below
+ the directories of a search path.
+
+ A background thread builds the map, and then checks the search path setting
+ and the modification time of every indexed directory, rebuilding the map when
+ anything changes. Lookups never touch the disk or allocate memory.
+ */
+class CybrSearchIndex : private juce::Thread {
+public:
+    CybrSearchIndex(const juce::String& settingsKey, int pollIntervalMs);
+    ~CybrSearchIndex();
+
+    /** Find a file by its path relative to one of the search directories.
+     Earlier directories take priority, as with CybrSearchPath::find. Returns
+     false if the path is not in the index (or the index is not ready yet).
+     Thread safe. */
+    bool find(juce::StringRef filePath, juce::File& result) const;
+
+    /** The number of indexed files, or -1 if the index is not ready */
+    int getNumFiles() const;
+
+private:
+    struct Entry {
+        /** Always uses '/' as the separator */
+        juce::String relativePath;
+        juce::File file;
+    };
+    struct Index {
+        juce::String pathString;
+        /** Keyed by hash, with one entry per relative path */
+        std::unordered_multimap<juce::uint64, Entry> files;
+        juce::Array<juce::File> directories;
+        juce::Array<juce::Time> modified;
+    };
+
+    void run() override;
+    bool isStale(const Index& index, const juce::String& pathString) const;
+    static std::shared_ptr<const Index> scan(const juce::String& pathString);
+    /** Hash a relative path, treating '\\' as '/'. Returns false for absolute
+     paths, and paths with "." or ".." segments, which are not indexed. */
+    static bool hashRelativePath(juce::StringRef path, juce::uint64& hash);
+    static bool isSamePath(juce::StringRef path, const juce::String& relativePath);
+
+    const juce::String settingsKey;
+    const int pollIntervalMs;
+    juce::SpinLock indexLock;
+    std::shared_ptr<const Index> index;
+};
+
 /** Helper class for dealing with search paths */
 class CybrSearchPath {
 public:
@@ -30,6 +81,12 @@ public:
     juce::String key() const;
     juce::Array<juce::File> paths() const;
     juce::File find(const juce::StringRef filePath) const;
+
+    /** Index the preset and sample search paths, so that find() can usually
+     answer from memory. The index checks for changes every pollIntervalMs. */
+    static void startIndexing(int pollIntervalMs);
+    static void stopIndexing();
 private:
+    static std::shared_ptr<CybrSearchIndex> getIndex(const juce::String& name);
     const juce::String name;
 };
@@ -12,10 +12,13 @@
 #include <iostream>
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "CybrEdit.h"
+#include "CybrLog.h"
+#include "TimestampedOscMessage.h"
 
 class CybrEdit;
 const juce::Identifier CYBRTRACK ("CYBRTRACK");
 const juce::Identifier CE ("CE"); // CYBR EVENT
+const juce::Identifier CEA ("a"); // CYBR EVENT ADDRESS
 
 class CybrTrack {
 public:
@@ -26,16 +29,22 @@ public:
             auto& var = lastChild[te::IDs::t];
             lastEventTime = var;
         }
-        std::cout << "Created CYBRTRACK. lastEventTime: " << lastEventTime << std::endl;
+        CYBR_LOG(info, audio, "Created CYBRTRACK. lastEventTime: " << lastEventTime);
     }
-    ~CybrTrack() { std::cout << "Deleted CYBRTRACK" << std::endl; }
+    ~CybrTrack() { CYBR_LOG(info, audio, "Deleted CYBRTRACK"); }
 
     /** Add an event to the track unless the supplied time is less than
-        the previously added event time. Returns true on success. */
-    bool addEvent(double time, int value) {
+        the previously added event time. Returns true on success.
+        The first argument of the message is stored as v, and any others as
+        v1, v2, etc. */
+    bool addEvent(double time, const TimestampedOscMessage& message) {
         if (time >= lastEventTime) {
             lastEventTime = time;
-            state.addChild({CE, {{te::IDs::t, time}, {te::IDs::v, value}}}, -1, nullptr);
+            juce::ValueTree event(CE, {{te::IDs::t, time}, {CEA, message.getAddress()}});
+            for (int i = 0; i < message.getNumArgs(); i++) {
+                event.setProperty(i ? juce::Identifier("v" + juce::String(i)) : te::IDs::v, message.getVar(i), nullptr);
+            }
+            state.addChild(event, -1, nullptr);
             return true;
         } else {
             return false;
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    CybrWidthPlugin.cpp
+    Created: 16 Oct 2026 8:44:08pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "CybrWidthPlugin.h"
+
+using namespace juce;
+
+namespace {
+    const Identifier widthID("width");
+    const Identifier widthAutomationID("widthAutomation");
+}
+
+CybrWidthPlugin::CybrWidthPlugin(te::PluginCreationInfo info) : te::Plugin(info)
+{
+    auto um = getUndoManager();
+    widthValue.referTo(state, widthID, um, 1.f);
+    widthAutomationValue.referTo(state, widthAutomationID, um, 1.f);
+
+    width = addParam("width", TRANS("Width"), { -1.f, 1.f });
+    widthAutomation = addParam("width automation", TRANS("Width Automation"), { -1.f, 1.f });
+
+    width->attachToCurrentValue(widthValue);
+    widthAutomation->attachToCurrentValue(widthAutomationValue);
+}
+
+CybrWidthPlugin::~CybrWidthPlugin()
+{
+    notifyListenersOfDeletion();
+
+    width->detachFromCurrentValue();
+    widthAutomation->detachFromCurrentValue();
+}
+
+ValueTree CybrWidthPlugin::create()
+{
+    ValueTree v (te::IDs::PLUGIN);
+    v.setProperty (te::IDs::type, xmlTypeName, nullptr);
+    return v;
+}
+
+const char* CybrWidthPlugin::xmlTypeName = "cybr-width";
+
+void CybrWidthPlugin::initialise(const te::PlaybackInitialisationInfo& info)
+{
+    sideSize = jmax(info.blockSizeSamples, 256);
+    side.allocate((size_t)sideSize, true);
+    lastWidth = width->getCurrentValue() * widthAutomation->getCurrentValue();
+}
+
+void CybrWidthPlugin::deinitialise()
+{
+    side.free();
+    sideSize = 0;
+}
+
+// Called from a "mixer" thread. (There can be multiple "mixer" threads)
+void CybrWidthPlugin::applyToBuffer(const te::PluginRenderContext& fc)
+{
+    if (fc.destBuffer == nullptr || fc.bufferNumSamples == 0) return;
+    // Width has no meaning for a mono signal. The volume plugin after this
+    // one pans it.
+    if (fc.destBuffer->getNumChannels() < 2 || sideSize == 0) return;
+
+    const float newWidth = width->getCurrentValue() * widthAutomation->getCurrentValue();
+    const int start = fc.bufferStartSample;
+    const int numSamples = fc.bufferNumSamples;
+
+    // Width 1 leaves the signal unchanged, which is the usual case
+    if (lastWidth != 1.f || newWidth != 1.f) {
+        float* left = fc.destBuffer->getWritePointer(0, start);
+        float* right = fc.destBuffer->getWritePointer(1, start);
+        const float step = (newWidth - lastWidth) / (float)numSamples;
+        for (int done = 0; done < numSamples; done += sideSize) {
+            const int n = jmin(sideSize, numSamples - done);
+            applyWidth(left + done, right + done, n, lastWidth + step * done, lastWidth + step * (done + n));
+        }
+    }
+
+    lastWidth = newWidth;
+}
+
+void CybrWidthPlugin::applyWidth(float* left, float* right, int numSamples, float startWidth, float endWidth)
+{
+    // side = (L - R) / 2 * width
+    FloatVectorOperations::subtract(side, left, right, numSamples);
+    if (startWidth == endWidth) {
+        FloatVectorOperations::multiply(side, 0.5f * endWidth, numSamples);
+    } else {
+        const float start = 0.5f * startWidth;
+        const float step = 0.5f * (endWidth - startWidth) / (float)numSamples;
+        for (int i = 0; i < numSamples; i++) side[i] *= start + step * (float)i;
+    }
+    // mid = (L + R) / 2, stored in left
+    FloatVectorOperations::add(left, right, numSamples);
+    FloatVectorOperations::multiply(left, 0.5f, numSamples);
+    // R = mid - side, L = mid + side
+    FloatVectorOperations::subtract(right, left, side, numSamples);
+    FloatVectorOperations::add(left, side, numSamples);
+}
+
+String CybrWidthPlugin::getSelectableDescription()
+{
+    return TRANS("Cybr Width Plugin");
+}
+
+void CybrWidthPlugin::restorePluginStateFromValueTree(const juce::ValueTree& v)
+{
+    CachedValue<float>* cvsFloat[] = { &widthValue, &widthAutomationValue, nullptr };
+    te::copyPropertiesToNullTerminatedCachedValues(v, cvsFloat);
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    CybrWidthPlugin.h
+    Created: 16 Oct 2026 8:44:08pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Stereo width, applied with a mid/side kernel.
+
+ This replaces the "cybr-width" rack (five volume plugins and two of its three
+ macros) that earlier versions of cybr inserted on every track. The parameters
+ mirror the old macros, so existing automation carries over (see
+ migrateWidthRacks):
+ - "width" is set by /audiotrack/set/width without a time argument
+ - "width automation" receives width automation points. The output width is
+   width * width automation. 1 is unchanged, 0 is mono, -1 swaps channels.
+ Mono input passes through unchanged. Pan is not part of this plugin: pan
+ automation stays on the track's "pan automation" macro, which offsets the
+ volume plugin's pan (see ensurePanAutomationMacro), so that the volume
+ plugin's pan law applies and mono input is panned to stereo as before.
+ */
+class CybrWidthPlugin : public te::Plugin
+{
+public:
+    CybrWidthPlugin(te::PluginCreationInfo);
+    ~CybrWidthPlugin();
+    static juce::ValueTree create();
+
+    //==============================================================================
+    juce::CachedValue<float> widthValue, widthAutomationValue;
+    te::AutomatableParameter::Ptr width, widthAutomation;
+
+    // Overridden from Plugin ======================================================
+    static const char* getPluginName() { return NEEDS_TRANS("Width"); }
+    static const char* xmlTypeName;
+
+    juce::String getName() override { return TRANS("Cybr Width"); }
+    juce::String getPluginType() override { return xmlTypeName; }
+    juce::String getShortName(int) override { return "Width"; }
+
+    void initialise(const te::PlaybackInitialisationInfo&) override;
+    void deinitialise() override;
+    double getLatencySeconds() override { return 0.0; }
+    int getNumOutputChannelsGivenInputs(int numInputChannels) override { return juce::jmin(numInputChannels, 2); }
+    bool canBeAddedToClip() override { return false; }
+    bool needsConstantBufferSize() override { return false; }
+
+    void applyToBuffer(const te::PluginRenderContext&) override;
+    // Overridden from Selectable ==================================================
+
+    juce::String getSelectableDescription() override;
+
+    // Overridden from AutomatableEditItem =========================================
+    void restorePluginStateFromValueTree(const juce::ValueTree&) override;
+
+private:
+    void applyWidth(float* left, float* right, int numSamples, float startWidth, float endWidth);
+
+    /** Scratch space for the side channel, allocated by initialise() */
+    juce::HeapBlock<float> side;
+    int sideSize = 0;
+    /** The width used at the end of the previous block. Changes are ramped
+     over a block to avoid zipper noise. */
+    float lastWidth = 1.f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CybrWidthPlugin)
+};
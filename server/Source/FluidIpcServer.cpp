@@ -9,39 +9,298 @@
 */
 
 #include "FluidIpcServer.h"
+#include "CybrLog.h"
+
+#if ! JUCE_WINDOWS
+ #include <cerrno>
+ #include <unistd.h>
+ #include <sys/socket.h>
+#endif
 
 using namespace juce;
 
 //==============================================================================
 InterprocessConnection* FluidIpcServer::createConnectionObject(){
-    std::cout<<"Creating interprocess connection"<<std::endl;
-    
+    CYBR_LOG(info, ipc, "Creating interprocess connection");
+    const ScopedLock sl(ipcMapLock);
+
     while(ipcMap.find(ipc_num) != ipcMap.end()){
         ipc_num += 1;
         ipc_num %= threshold;
     }
-        
-    ipcMap[ipc_num].setFluidServer(*fluidOscServer);
-    ipcMap[ipc_num].setIpcServer(*this);
-    ipcMap[ipc_num].setIpcNum(ipc_num);
+
+    auto& ipc = ipcMap[ipc_num];
+    ipc = std::make_unique<FluidIpc>(pipelined, sessions);
+    ipc->setFluidServer(*fluidOscServer);
+    ipc->setIpcServer(*this);
+    ipc->setIpcNum(ipc_num);
     
-    return &ipcMap[ipc_num];
+    return ipc.get();
 }
 
-FluidIpcServer::FluidIpcServer(FluidOscServer& server) : fluidOscServer(&server){
+FluidIpcServer::FluidIpcServer(FluidOscServer& server, bool pipelined, bool sessions)
+: pipelined(pipelined), sessions(sessions), fluidOscServer(&server){
 }
 
 void FluidIpcServer::removeIpcConn(int ipc_conn){
-    ipcMap.erase(ipc_conn);
+    std::unique_ptr<FluidIpc> removed;
+    {
+        const ScopedLock sl(ipcMapLock);
+        auto it = ipcMap.find(ipc_conn);
+        if (it == ipcMap.end()) return;
+        removed = std::move(it->second);
+        ipcMap.erase(it);
+    }
+    // removed is deleted here, outside of the lock
+}
+
+//==============================================================================
+namespace {
+    /** InterprocessConnection's default. fluid-music's IpcClient uses the same
+     value. */
+    const uint32 ipcMagicMessageHeader = 0xf2b49e2c;
+}
+
+namespace {
+    /** cybr replies report errors with a non-zero int as the first argument */
+    bool isErrorReply(const OSCMessage& reply) {
+        return reply.size() && reply[0].isInt32() && reply[0].getInt32() != 0;
+    }
+
+    void collectErrors(const OSCBundle& reply, int& numMessages, Array<const OSCMessage*>& errors) {
+        for (const auto& element : reply) {
+            if (element.isBundle()) {
+                collectErrors(element.getBundle(), numMessages, errors);
+                continue;
+            }
+            numMessages++;
+            if (isErrorReply(element.getMessage())) errors.add(&element.getMessage());
+        }
+    }
+}
+
+OSCBundle::Element FluidReplyMode::apply(const OSCBundle& reply) const {
+    if (mode == full) return OSCBundle::Element(reply);
+
+    int numMessages = 0;
+    Array<const OSCMessage*> errors;
+    collectErrors(reply, numMessages, errors);
+
+    if (mode == errorsOnly) {
+        OSCBundle errorBundle;
+        for (auto error : errors) errorBundle.addElement(*error);
+        return OSCBundle::Element(errorBundle);
+    }
+
+    OSCMessage summary("/bundle/summary");
+    summary.addInt32(numMessages);
+    summary.addInt32(errors.size());
+    for (int i = 0; i < jmin(maxErrors, errors.size()); i++) {
+        const OSCMessage& error = *errors[i];
+        summary.addString(error.getAddressPattern().toString());
+        summary.addString(error.size() >= 2 && error[1].isString() ? error[1].getString() : String());
+    }
+    return OSCBundle::Element(summary);
+}
+
+OSCMessage FluidReplyMode::set(const OSCMessageView& message) {
+    // Args
+    // 0 - (string, required) "full", "errors", or "summary"
+    // 1 - (int, optional) the most errors to include in a summary
+    OSCMessage reply("/reply/mode/reply");
+    if (!message.size() || !message[0].isString()) {
+        reply.addInt32(1);
+        reply.addString("Cannot set reply mode: Missing mode string");
+        return reply;
+    }
+
+    if (message[0].getStringView() == "full") mode = full;
+    else if (message[0].getStringView() == "errors") mode = errorsOnly;
+    else if (message[0].getStringView() == "summary") mode = summary;
+    else {
+        reply.addInt32(1);
+        reply.addString("Cannot set reply mode: Unknown mode: " + message[0].getString());
+        return reply;
+    }
+    if (message.size() >= 2 && message[1].isInt32()) maxErrors = jmax(0, message[1].getInt32());
+
+    reply.addInt32(0);
+    return reply;
+}
+
+//==============================================================================
+bool FluidIpcEncodeBuffer::encode(const OSCMessage& message) {
+    return encodeData(message);
+}
+
+bool FluidIpcEncodeBuffer::encode(const OSCBundle& bundle) {
+    return encodeData(bundle);
+}
+
+namespace {
+    bool writeOscData(OSCOutputStream& outstream, const OSCMessage& message) { return outstream.writeMessage(message); }
+    bool writeOscData(OSCOutputStream& outstream, const OSCBundle& bundle) { return outstream.writeBundle(bundle); }
+}
+
+template <typename OscData>
+bool FluidIpcEncodeBuffer::encodeData(const OscData& data) {
+    const size_t oscSize = OSCOutputStream::getEncodedSize(data);
+    size = 0;
+    if (oscSize > (size_t)std::numeric_limits<int>::max()) return false;
+
+    const size_t frameSize = headerSize + oscSize;
+    if (frameSize > capacity) {
+        // Grow geometrically, so a series of slightly larger replies does not
+        // reallocate every time
+        capacity = jmax(frameSize, capacity + capacity / 2, (size_t)4096);
+        buffer.free();
+        buffer.malloc(capacity);
+    }
+
+    OSCOutputStream outstream(buffer.getData() + headerSize, oscSize);
+    bool encoded = writeOscData(outstream, data);
+    if (!encoded || outstream.getDataSize() != oscSize) return false;
+
+    // The same header InterprocessConnection::sendMessage writes
+    const uint32 header[] = { ByteOrder::swapIfBigEndian(magicMessageHeader),
+                              ByteOrder::swapIfBigEndian((uint32)oscSize) };
+    memcpy(buffer.getData(), header, headerSize);
+
+    size = oscSize;
+    return true;
+}
+
+//==============================================================================
+FluidIpcReplyWriter::FluidIpcReplyWriter(FluidIpc& connection)
+: Thread("FluidIpcReplyWriter"), connection(connection) {
+    startThread();
+}
+
+FluidIpcReplyWriter::~FluidIpcReplyWriter() {
+    signalThreadShouldExit();
+    wakeUp.signal();
+    streamedSent.signal();
+    stopThread(2000);
+}
+
+std::shared_ptr<FluidIpcReplyWriter::Slot> FluidIpcReplyWriter::reserve(const FluidReplyMode& replyMode) {
+    auto slot = std::make_shared<Slot>();
+    slot->replyMode = replyMode;
+    const ScopedLock sl(lock);
+    slots.push_back(slot);
+    return slot;
+}
+
+void FluidIpcReplyWriter::fulfil(std::shared_ptr<Slot> slot, const OSCBundle::Element& reply) {
+    {
+        const ScopedLock sl(lock);
+        jassert(!slot->reply);
+        slot->reply = std::make_unique<OSCBundle::Element>(reply);
+    }
+    wakeUp.signal();
+}
+
+bool FluidIpcReplyWriter::stream(std::shared_ptr<Slot> slot, const OSCMessage& message) {
+    const uint32 startMs = Time::getMillisecondCounter();
+    for (;;) {
+        {
+            const ScopedLock sl(lock);
+            jassert(!slot->reply);
+            if (slot->streamFailed) return false;
+            // Only the front slot's messages are being sent, so waiting on any
+            // other slot could wait forever
+            const bool full = slot->streamed.size() >= maxStreamed
+                && !slots.empty() && slots.front() == slot
+                && !threadShouldExit();
+            if (!full) {
+                slot->streamed.push_back(message);
+                break;
+            }
+            // The writer thread takes every waiting message at once, so if
+            // the queue is still full, nothing was sent in all that time. The
+            // client is not reading, and the caller (usually the message
+            // thread) must not wait for it forever.
+            if ((int)(Time::getMillisecondCounter() - startMs) >= streamTimeoutMs) {
+                slot->streamFailed = true;
+                CYBR_LOG(warning, ipc, "Stopped streaming: Nothing was sent for " << streamTimeoutMs << "ms");
+                return false;
+            }
+        }
+        wakeUp.signal();
+        streamedSent.wait(100);
+    }
+    wakeUp.signal();
+    return true;
+}
+
+void FluidIpcReplyWriter::run() {
+    while (!threadShouldExit()) {
+        std::shared_ptr<Slot> next;
+        std::deque<OSCMessage> streamed;
+        {
+            const ScopedLock sl(lock);
+            if (!slots.empty()) {
+                streamed.swap(slots.front()->streamed);
+                if (slots.front()->reply) {
+                    next = slots.front();
+                    slots.pop_front();
+                }
+            }
+        }
+
+        for (const auto& message : streamed) {
+            if (connection.sendOSCMessage(message))
+                CYBR_LOG(warning, ipc, "Failed to send streamed message: " << message.getAddressPattern().toString());
+        }
+        if (!streamed.empty()) streamedSent.signal();
+
+        if (!next) {
+            if (streamed.empty()) wakeUp.wait(100);
+            continue;
+        }
+
+        // Shaping the reply here keeps that work off the message thread
+        const OSCBundle::Element& reply = *next->reply;
+        bool failed = reply.isBundle()
+            ? connection.sendOSCElement(next->replyMode.apply(reply.getBundle()), next->metrics)
+            : connection.sendOSCMessage(reply.getMessage(), next->metrics);
+        if (failed) {
+            // Every request must get exactly one reply, or the client will
+            // lose track of which reply belongs to which request.
+            OSCMessage error("/error");
+            error.addString("encoding reply failed");
+            connection.sendOSCMessage(error);
+        }
+    }
 }
 
 //==============================================================================
+FluidIpc::FluidIpc(bool pipelined, bool useSession)
+: InterprocessConnection(!pipelined, ipcMagicMessageHeader), pipelined(pipelined), encodeBuffer(ipcMagicMessageHeader) {
+    weakSelf = this;
+    if (pipelined) replyWriter = std::make_unique<FluidIpcReplyWriter>(*this);
+    if (useSession) {
+        // Connections are created on the InterprocessConnectionServer's
+        // thread, but the session (like the edits it will own) belongs to the
+        // message thread, so wait for the message thread to create it.
+        session.reset(static_cast<FluidOscServer*>(MessageManager::getInstance()->callFunctionOnMessageThread(
+            [](void*) -> void* { return new FluidOscServer(); }, nullptr)));
+        if (session) fluidOscServer = session.get();
+        else CYBR_LOG(warning, ipc, "Failed to create a session. The connection will use the shared server");
+    }
+}
+
 FluidIpc::~FluidIpc() {
+    // The writer thread sends on the socket, so stop it before the socket is
+    // deleted by disconnect()
+    replyWriter.reset();
+    closeWriteHandle();
     disconnect();
 }
 
 void FluidIpc::setFluidServer(FluidOscServer& server){
-    fluidOscServer = &server;
+    // A connection with its own session never uses the shared server
+    if (!session) fluidOscServer = &server;
 }
 
 void FluidIpc::setIpcServer(FluidIpcServer& server){
@@ -49,7 +308,59 @@ void FluidIpc::setIpcServer(FluidIpcServer& server){
 }
 
 void FluidIpc::connectionMade(){
-    std::cout<<"Connection Made"<<std::endl;
+    CYBR_LOG(info, ipc, "Connection Made");
+    // Pipelined connections are told about the connection synchronously,
+    // before the connection thread that may delete the socket is started, so
+    // the socket is safe to use here. Otherwise this is called later on the
+    // message thread, and replies go through sendMessage.
+    if (pipelined) openWriteHandle();
+}
+
+void FluidIpc::openWriteHandle(){
+   #if ! JUCE_WINDOWS
+    auto* socket = getSocket();
+    if (!socket || socket->getRawSocketHandle() < 0) return;
+    const int handle = ::dup(socket->getRawSocketHandle());
+    if (handle < 0) {
+        CYBR_LOG(warning, ipc, "Failed to duplicate the socket handle. Replies will be copied by sendMessage");
+        return;
+    }
+   #if JUCE_MAC || JUCE_IOS
+    const int noSigPipe = 1;
+    ::setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+   #endif
+    const ScopedLock sl(sendLock);
+    writeHandle = handle;
+   #endif
+}
+
+void FluidIpc::closeWriteHandle(){
+    const ScopedLock sl(sendLock);
+   #if ! JUCE_WINDOWS
+    if (writeHandle >= 0) ::close(writeHandle);
+   #endif
+    writeHandle = -1;
+}
+
+bool FluidIpc::writeFrame(const char* data, size_t size){
+   #if ! JUCE_WINDOWS
+   #if JUCE_LINUX
+    const int flags = MSG_NOSIGNAL;
+   #else
+    const int flags = 0;
+   #endif
+    while (size > 0) {
+        const ssize_t written = ::send(writeHandle, data, size, flags);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+   #else
+    ignoreUnused(data, size);
+    return false;
+   #endif
 }
 
 void FluidIpc::setIpcNum(int num){
@@ -57,54 +368,155 @@ void FluidIpc::setIpcNum(int num){
 }
 
 void FluidIpc::connectionLost(){
-    std::cout<<"Connection Lost"<<std::endl;
+    CYBR_LOG(info, ipc, "Connection Lost");
+    // Waits for a write in progress, and stops replies to a closed connection
+    closeWriteHandle();
+    if (pipelined) {
+        // We are on the connection thread, which cannot delete its own
+        // connection. Remove it from the message thread instead.
+        FluidIpcServer* server = fluidIpcServer;
+        int num = ipc_num;
+        MessageManager::callAsync([server, num] { server->removeIpcConn(num); });
+        return;
+    }
     fluidIpcServer->removeIpcConn(ipc_num);
 }
 
-bool FluidIpc::sendOSCBundle(const OSCBundle& reply){
-    OSCOutputStream outstream;
-//    std::cout<<reply[0].getMessage().getAddressPattern().toString()<<std::endl;
-    if(outstream.writeBundle(reply)){
-        MemoryBlock reply_block(outstream.getData(), outstream.getDataSize());
-//        std::cout<<outstream.getDataSize()<<std::endl;
-//        std::cout<<reply_block.toBase64Encoding()<<std::endl;
-        if(this->sendMessage(reply_block)){
-            return 0;
-        }
-        
-    }
-    return 1;
+template <typename OscData>
+bool FluidIpc::sendEncoded(const OscData& reply, OscMetrics::Address* metrics){
+    const ScopedLock sl(sendLock);
+    const double startMs = Time::getMillisecondCounterHiRes();
+    if (!encodeBuffer.encode(reply)) return true;
+    if (metrics) metrics->encode.record(OscMetrics::elapsedMicroseconds(startMs));
+
+    // Our own handle stays open until closeWriteHandle, which takes sendLock,
+    // so the frame goes out in one write from the encode buffer
+    if (writeHandle >= 0) return !writeFrame(encodeBuffer.getFrame(), encodeBuffer.getFrameSize());
+
+    // Without one, sendMessage copies the payload to add the header, and
+    // writes under InterprocessConnection's own lock
+    return !sendMessage(MemoryBlock(encodeBuffer.getPayload(), encodeBuffer.getPayloadSize()));
+}
+
+bool FluidIpc::sendOSCElement(const OSCBundle::Element& reply, OscMetrics::Address* metrics){
+    return reply.isBundle() ? sendEncoded(reply.getBundle(), metrics) : sendEncoded(reply.getMessage(), metrics);
+}
+
+bool FluidIpc::sendOSCBundle(const OSCBundle& reply, OscMetrics::Address* metrics){
+    return sendEncoded(reply, metrics);
+}
+
+bool FluidIpc::sendOSCMessage(const OSCMessage& reply, OscMetrics::Address* metrics){
+    return sendEncoded(reply, metrics);
 }
 
-bool FluidIpc::sendOSCMessage(const OSCMessage& reply){
-    OSCOutputStream outstream;
-    if(outstream.writeMessage(reply)){
-        MemoryBlock reply_block(outstream.getData(), outstream.getDataSize());
-        this->sendMessage(reply_block);
-        return 0;
+namespace {
+    /** The reply mode belongs to the connection, so FluidIpc handles these
+     messages itself instead of passing them to the FluidOscServer */
+    bool isReplyModeMessage(const OSCElementView& elem) {
+        return !elem.isBundle && elem.message.getAddress() == "/reply/mode";
     }
-    return 1;
 }
 
 void FluidIpc::messageReceived(const MemoryBlock &message){
-    OSCInputStream instream(message.getData(), message.getSize());
-    OSCBundle::Element elem = instream.readElementWithKnownSize(message.getSize());
-    
-    if(elem.isBundle()){
+    if (pipelined) {
+        // Decode here on the connection thread. The packet keeps its own copy
+        // of the data, and the decoded views point into that copy, so strings
+        // and blobs are not copied again before the handlers read them.
+        std::shared_ptr<const OscPacket> packet;
+        try {
+            packet = OscPacket::decode(message);
+        } catch (const OSCFormatError& e) {
+            CYBR_LOG(error, ipc, "Cannot decode OSC packet: " << e.description);
+        }
+
+        // Reserve this request's place in the reply order, then queue it for
+        // the message thread, which handles edit mutations one at a time, in
+        // order.
+        auto slot = replyWriter->reserve(replyMode);
+        if (!packet) {
+            OSCMessage error("/error");
+            error.addString("decoding OSC packet failed");
+            replyWriter->fulfil(slot, error);
+            return;
+        }
+        if (isReplyModeMessage(packet->element)) {
+            replyWriter->fulfil(slot, replyMode.set(packet->element.message));
+            return;
+        }
+        slot->metrics = fluidOscServer->getMetrics(packet->element);
+        if (slot->metrics) slot->metrics->decode.record(packet->decodeMicroseconds);
+        WeakReference<FluidIpc> self = weakSelf;
+        MessageManager::callAsync([self, slot, packet] {
+            FluidIpc* ipc = self.get();
+            if (!ipc) return;
+            // Handlers may reply later (see FluidOscServer::deferReply), from
+            // any thread. Those replies are handed back to the message thread,
+            // where it is safe to check that the connection still exists.
+            // Streamed messages take the same route, so they stay ahead of
+            // the reply.
+            ipc->fluidOscServer->enqueue(packet, [self, slot](const OSCBundle::Element& reply) {
+                if (MessageManager::getInstance()->isThisTheMessageThread()) {
+                    if (FluidIpc* ipc = self.get()) ipc->replyWriter->fulfil(slot, reply);
+                    return;
+                }
+                MessageManager::callAsync([self, slot, reply] {
+                    if (FluidIpc* ipc = self.get()) ipc->replyWriter->fulfil(slot, reply);
+                });
+            }, [self, slot](const OSCMessage& message) {
+                if (MessageManager::getInstance()->isThisTheMessageThread()) {
+                    FluidIpc* ipc = self.get();
+                    return ipc && ipc->replyWriter->stream(slot, message);
+                }
+                // Callers on other threads do not wait, so only callers on the
+                // message thread are told about a timeout
+                MessageManager::callAsync([self, slot, message] {
+                    if (FluidIpc* ipc = self.get()) ipc->replyWriter->stream(slot, message);
+                });
+                return true;
+            });
+        });
+        return;
+    }
+
+    // Everything happens before this function returns, so the views can
+    // point directly into message.
+    OSCElementView elem;
+    const double startMs = Time::getMillisecondCounterHiRes();
+    try {
+        OSCInputStream instream(message.getData(), message.getSize());
+        elem = instream.readElementViewWithKnownSize(message.getSize());
+    } catch (const OSCFormatError& e) {
+        OSCMessage error("/error");
+        error.addString("decoding OSC packet failed: " + e.description);
+        this->sendOSCMessage(error);
+        return;
+    }
+
+    if (isReplyModeMessage(elem)) {
+        this->sendOSCMessage(replyMode.set(elem.message));
+        return;
+    }
+    OscMetrics::Address* metrics = fluidOscServer->getMetrics(elem);
+    if (metrics) metrics->decode.record(OscMetrics::elapsedMicroseconds(startMs));
+
+    if(elem.isBundle){
         // Pass the current selection in to the bundle handler
         SelectedObjects obj = fluidOscServer->getSelectedObjects();
-        OSCBundle bundle = elem.getBundle();
-        OSCBundle reply = fluidOscServer->handleOscBundle(bundle, obj);
-        if(this->sendOSCBundle(reply)){
+        OSCBundle reply = fluidOscServer->handleOscBundle(elem, obj);
+        if(this->sendOSCElement(replyMode.apply(reply), metrics)){
             OSCMessage error("/error");
             error.addString("sendOSCBundle failed");
             this->sendOSCMessage(error);
         }
     }
     else{
-        OSCMessage msg = elem.getMessage();
-        OSCMessage reply = fluidOscServer->handleOscMessage(msg);
-        if(this->sendOSCMessage(reply)){
+        // Without a writer thread, a streamed message would be written to the
+        // socket on the message thread, which blocks for as long as the client
+        // does not read. Streaming is only offered to pipelined connections,
+        // where FluidIpcReplyWriter::stream can give up after a timeout.
+        OSCMessage reply = fluidOscServer->handleOscMessage(elem.message);
+        if(this->sendOSCMessage(reply, metrics)){
             OSCMessage error("/error");
             error.addString("sendOSCMessage failed");
             this->sendOSCMessage(error);
@@ -10,45 +10,201 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "temp_OSCInputStream.h"
 #include "temp_OSCOutputStream.h"
 #include "FluidOscServer.h"
+#include "OscMetrics.h"
 
 using namespace juce;
 
 class FluidIpc;
 class FluidIpcServer;
 
+//==============================================================================
+/** How a connection replies to bundles. Clients change it with /reply/mode.
+ Replies to single messages are always sent in full. */
+struct FluidReplyMode {
+    enum Mode {
+        /** Mirror the request bundle, with one reply per message */
+        full,
+        /** A flat bundle containing only the replies that report an error */
+        errorsOnly,
+        /** A single /bundle/summary message with the number of messages, the
+         number of errors, and the address and text of the first maxErrors */
+        summary
+    };
+    Mode mode = full;
+    int maxErrors = 10;
+
+    /** Get the reply to send for a bundle, according to mode */
+    OSCBundle::Element apply(const OSCBundle& reply) const;
+    /** Handle a /reply/mode message, returning the reply */
+    OSCMessage set(const OSCMessageView& message);
+};
+
+//==============================================================================
+/** A reusable buffer for encoding replies. The encoded size is measured
+ first, and the InterprocessConnection frame header (magic number and payload
+ size) is written in front of the OSC payload, so the whole frame can be sent
+ with one write. The buffer only grows, so once it is large enough, encoding a
+ reply does not allocate. */
+class FluidIpcEncodeBuffer {
+public:
+    explicit FluidIpcEncodeBuffer(uint32 magicMessageHeader) : magicMessageHeader(magicMessageHeader) {}
+
+    /** Encode a message or bundle, replacing the previous contents. Returns
+     false if it could not be encoded. */
+    bool encode(const OSCMessage& message);
+    bool encode(const OSCBundle& bundle);
+
+    /** The header followed by the payload */
+    const char* getFrame() const noexcept { return buffer.getData(); }
+    size_t getFrameSize() const noexcept { return size == 0 ? 0 : headerSize + size; }
+    /** The OSC payload alone */
+    const char* getPayload() const noexcept { return buffer.getData() + headerSize; }
+    size_t getPayloadSize() const noexcept { return size; }
+
+    static constexpr size_t headerSize = 2 * sizeof(uint32);
+
+private:
+    template <typename OscData>
+    bool encodeData(const OscData& data);
+
+    const uint32 magicMessageHeader;
+    HeapBlock<char> buffer;
+    size_t capacity = 0;
+    size_t size = 0;
+};
+
+//==============================================================================
+/** Sends encoded replies on a background thread, in the order their slots
+ were reserved. Used by pipelined connections, where replies may be produced
+ out of order (for example when a handler replies asynchronously). */
+class FluidIpcReplyWriter : public Thread {
+public:
+    struct Slot {
+        std::unique_ptr<OSCBundle::Element> reply;
+        /** The connection's reply mode when the request was received */
+        FluidReplyMode replyMode;
+        /** Where to record the time spent encoding the reply, if anywhere */
+        OscMetrics::Address* metrics = nullptr;
+        /** Messages to send ahead of the reply (see FluidOscServer::getReplyStream) */
+        std::deque<OSCMessage> streamed;
+        /** Set when stream timed out. Later messages are refused. */
+        bool streamFailed = false;
+    };
+
+    FluidIpcReplyWriter(FluidIpc& connection);
+    ~FluidIpcReplyWriter();
+
+    /** Reserve the next position in the reply order. Thread safe. */
+    std::shared_ptr<Slot> reserve(const FluidReplyMode& replyMode);
+
+    /** Store the reply for a reserved slot. May be called from any thread.
+     The writer thread encodes and sends the reply once every earlier slot has
+     been sent. */
+    void fulfil(std::shared_ptr<Slot> slot, const OSCBundle::Element& reply);
+
+    /** Send a message before the slot's reply. Streamed messages are sent in
+     the order they are given, as soon as every earlier slot has been sent, and
+     must not be given after the slot is fulfilled. If maxStreamed messages
+     are already waiting to be sent for the slot at the front of the queue,
+     this blocks until the writer thread catches up, or until
+     streamTimeoutMs have passed. Returns false if it timed out (or timed out
+     earlier for this slot), in which case the message is not sent. May be
+     called from any thread. */
+    bool stream(std::shared_ptr<Slot> slot, const OSCMessage& message);
+
+    /** How many streamed messages may wait to be sent, per slot */
+    static constexpr size_t maxStreamed = 16;
+    /** How long stream waits for the client to read earlier messages */
+    static constexpr int streamTimeoutMs = 10000;
+
+    void run() override;
+
+private:
+    FluidIpc& connection;
+    CriticalSection lock;
+    WaitableEvent wakeUp;
+    /** Signalled by the writer thread after it sends streamed messages */
+    WaitableEvent streamedSent;
+    std::deque<std::shared_ptr<Slot>> slots;
+};
+
 //==============================================================================
 class FluidIpc : public InterprocessConnection{
 public:
+    /** When pipelined is true, messages are decoded on the connection thread,
+     handled in order on the message thread, and encoded and sent on a writer
+     thread. Otherwise everything happens on the message thread.
+
+     When useSession is true, the connection gets its own FluidOscServer, with
+     its own active edit and selection, instead of sharing the server passed
+     to setFluidServer. The session is created on the message thread, and the
+     constructor blocks until it exists. */
+    FluidIpc(bool pipelined = false, bool useSession = false);
     ~FluidIpc();
     void connectionMade() override;
     void connectionLost() override;
     void messageReceived(const MemoryBlock& message) override;
     
-    bool sendOSCBundle(const OSCBundle& bundle);
-    bool sendOSCMessage(const OSCMessage& message);
+    /** Encode and send a reply. Like the methods below, returns true if the
+     reply could not be encoded or sent. If metrics is supplied, the encoding
+     time is recorded there. Thread safe. */
+    bool sendOSCElement(const OSCBundle::Element& element, OscMetrics::Address* metrics = nullptr);
+    bool sendOSCBundle(const OSCBundle& bundle, OscMetrics::Address* metrics = nullptr);
+    bool sendOSCMessage(const OSCMessage& message, OscMetrics::Address* metrics = nullptr);
+    bool isPipelined() const { return pipelined; }
     void setFluidServer(FluidOscServer& server);
     void setIpcServer(FluidIpcServer& server);
     void setIpcNum(int ipc_num);
 private:
     int ipc_num;
+    bool pipelined;
     FluidOscServer* fluidOscServer = nullptr;
     FluidIpcServer* fluidIpcServer = nullptr;
+    std::unique_ptr<FluidOscServer> session;
+    std::unique_ptr<FluidIpcReplyWriter> replyWriter;
+    WeakReference<FluidIpc> weakSelf;
+    /** Only used by the thread that calls messageReceived */
+    FluidReplyMode replyMode;
+    CriticalSection sendLock;
+    FluidIpcEncodeBuffer encodeBuffer;
+    /** A duplicate of the socket's handle, owned by this connection and only
+     used under sendLock, so encoded frames can be written directly. The
+     connection thread deletes the socket itself when a read fails, which
+     does not close this handle. -1 when replies go through sendMessage. */
+    int writeHandle = -1;
+
+    void openWriteHandle();
+    void closeWriteHandle();
+    /** Write a whole frame to writeHandle. Returns false on failure. */
+    bool writeFrame(const char* data, size_t size);
+
+    template <typename OscData>
+    bool sendEncoded(const OscData& data, OscMetrics::Address* metrics);
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(FluidIpc)
 };
 
 //==============================================================================
 class FluidIpcServer : public InterprocessConnectionServer{
 public:
-    FluidIpcServer(FluidOscServer& server);
+    /** server is shared by every connection, unless sessions is true, in
+     which case each connection gets a FluidOscServer of its own. */
+    FluidIpcServer(FluidOscServer& server, bool pipelined = false, bool sessions = false);
     InterprocessConnection* createConnectionObject() override;
     void removeIpcConn(int ipc_conn_num);
     
 private:
     int ipc_num = 0;
     int threshold = 1000000000;
-    std::map<int, FluidIpc> ipcMap;
+    bool pipelined;
+    bool sessions;
+    CriticalSection ipcMapLock;
+    std::map<int, std::unique_ptr<FluidIpc>> ipcMap;
     FluidOscServer* fluidOscServer = nullptr;
 };
@@ -10,11 +10,13 @@
 
 #include "FluidOscServer.h"
 #include "plugin_report.h"
+#include "CybrLog.h"
 
 using namespace juce;
 
 //==============================================================================
 FluidOscServer::FluidOscServer() {
+    registerMethods();
     addListener (this);
 }
 
@@ -30,12 +32,13 @@ void FluidOscServer::oscMessageReceived(const OSCMessage &message){
 void FluidOscServer::constructReply(OSCMessage &reply, int error, String message){
     reply.addInt32(error);
     reply.addString(message);
-    std::cout<<message<<std::endl;
+    if (error) CYBR_LOG(error, osc, message);
+    else CYBR_LOG(info, osc, message);
 }
 
 void FluidOscServer::constructReply(OSCMessage &reply, String message){
     reply.addString(message);
-    std::cout<<message<<std::endl;
+    CYBR_LOG(info, osc, message);
 }
 
 SelectedObjects FluidOscServer::getSelectedObjects() {
@@ -43,6 +46,8 @@ SelectedObjects FluidOscServer::getSelectedObjects() {
 }
 
 OSCBundle FluidOscServer::handleOscBundle(const OSCBundle &bundle, SelectedObjects parentSelection) {
+    const double startMs = Time::getMillisecondCounterHiRes();
+    const ScopedValueSetter<int> depthSetter(bundleDepth, bundleDepth + 1);
     SelectedObjects currBundle = parentSelection;
     OSCBundle reply;
     for (const auto& element: bundle) {
@@ -63,70 +68,277 @@ OSCBundle FluidOscServer::handleOscBundle(const OSCBundle &bundle, SelectedObjec
     selectedTrack = parentSelection.audioTrack;
     selectedClip = parentSelection.clip;
     selectedPlugin = parentSelection.plugin;
+    // Nested bundles are part of their parent's time
+    if (bundleDepth == 1) OscMetrics::getInstance().get("#bundle").handle.record(OscMetrics::elapsedMicroseconds(startMs));
+    return reply;
+}
+
+OSCBundle FluidOscServer::handleOscBundle(const OSCElementView& bundle, SelectedObjects parentSelection) {
+    const double startMs = Time::getMillisecondCounterHiRes();
+    const ScopedValueSetter<int> depthSetter(bundleDepth, bundleDepth + 1);
+    SelectedObjects currBundle = parentSelection;
+    OSCBundle reply;
+    for (const auto& element: bundle.elements) {
+        if (!element.isBundle) {
+            // allow messages to update the current selection ("currBundle")
+            OSCMessage replyMessage = handleOscMessage(element.message);
+            currBundle.audioTrack = selectedTrack;
+            currBundle.clip = selectedClip;
+            currBundle.plugin = selectedPlugin;
+            reply.addElement(replyMessage);
+        } else {
+            // After processing a bundle, selection will reset to "currBundle"
+            OSCBundle replyBundle = handleOscBundle(element, currBundle);
+            reply.addElement(replyBundle);
+        }
+    }
+
+    selectedTrack = parentSelection.audioTrack;
+    selectedClip = parentSelection.clip;
+    selectedPlugin = parentSelection.plugin;
+    // Nested bundles are part of their parent's time
+    if (bundleDepth == 1) OscMetrics::getInstance().get("#bundle").handle.record(OscMetrics::elapsedMicroseconds(startMs));
     return reply;
 }
 
 OSCMessage FluidOscServer::handleOscMessage (const OSCMessage& message) {
-    const OSCAddressPattern msgAddressPattern = message.getAddressPattern();
+    const String address = message.getAddressPattern().toString();
+    if (const OscRoute* route = findRoute(address)) {
+        const double startMs = Time::getMillisecondCounterHiRes();
+        const bool wasDeferred = replyDeferred;
+        prepareRoute(*route);
+        OSCMessage reply = route->viewHandler
+            ? route->viewHandler(OSCMessageView::of(message))
+            : route->handler(message);
+        // Deferred replies are recorded when they are sent
+        if (!replyDeferred || wasDeferred) recordHandled(route->address, startMs, reply);
+        return reply;
+    }
 
-    if (msgAddressPattern.matches({"/test"}) || msgAddressPattern.matches({"/print"})) {
-        printOscMessage(message);
-        return message;
+    printOscMessage(message);
+    OSCMessage error("/error");
+    constructReply(error, 1, "Unhandled Message");
+    return error;
+}
+
+OSCMessage FluidOscServer::handleOscMessage (const OSCMessageView& message, StreamReplyFunc sendStream) {
+    const ScopedValueSetter<StreamReplyFunc> streamSetter(replyStream, sendStream);
+    const String address = message.getAddress();
+    if (const OscRoute* route = findRoute(address)) {
+        const double startMs = Time::getMillisecondCounterHiRes();
+        const bool wasDeferred = replyDeferred;
+        prepareRoute(*route);
+        OSCMessage reply("/error");
+        if (route->viewHandler) {
+            reply = route->viewHandler(message);
+        } else {
+            try {
+                reply = route->handler(message.toMessage());
+            } catch (const OSCFormatError& e) {
+                constructReply(reply, 1, "Invalid message: " + e.description);
+            }
+        }
+        // Deferred replies are recorded when they are sent
+        if (!replyDeferred || wasDeferred) recordHandled(route->address, startMs, reply);
+        return reply;
     }
-    if (msgAddressPattern.matches({"/file/activate"})) return activateEditFile(message);
-    if (msgAddressPattern.matches({"/audiofile/report"})) return getAudioFileReport(message);
 
-    if (!activeCybrEdit) {
+    CYBR_LOG(info, osc, "Unhandled message: " << address);
+    OSCMessage error("/error");
+    constructReply(error, 1, "Unhandled Message");
+    return error;
+}
+
+void FluidOscServer::recordHandled(const String& address, double startMs, const OSCMessage& reply) {
+    OscMetrics::Address& metrics = OscMetrics::getInstance().get(address);
+    metrics.handle.record(OscMetrics::elapsedMicroseconds(startMs));
+    if (reply.size() && reply[0].isInt32() && reply[0].getInt32() != 0) metrics.errors++;
+}
+
+void FluidOscServer::prepareRoute(const OscRoute& route) {
+    if (route.needsActiveEdit && !activeCybrEdit) {
         File file = File::getCurrentWorkingDirectory().getChildFile("empty.tracktionedit");
         activateEditFile(file, true);
     }
+}
 
-    if (msgAddressPattern.matches({"/midiclip/insert/note"})) return insertMidiNote(message);
-    if (msgAddressPattern.matches({"/midiclip/select"})) return selectMidiClip(message);
-    if (msgAddressPattern.matches({"/midiclip/clear"})) return clearMidiClip(message);
-    if (msgAddressPattern.matches({"/plugin/select"})) return selectPlugin(message);
-    if (msgAddressPattern.matches({"/plugin/param/set"})) return setPluginParam(message);
-    if (msgAddressPattern.matches({"/plugin/param/set/at"})) return setPluginParamAt(message);
-    if (msgAddressPattern.matches({"/plugin/sidechain/input/set" })) return setPluginSideChainInput(message);
-    if (msgAddressPattern.matches({"/plugin/save"})) return savePluginPreset(message);
-    if (msgAddressPattern.matches({"/plugin/load/trkpreset"})) return loadPluginTrkpreset(message);
-    if (msgAddressPattern.matches({"/plugin/load"})) return loadPluginPreset(message);
-    if (msgAddressPattern.matches({"/plugin/report"})) return getPluginReport(message);
-    if (msgAddressPattern.matches({"/plugin/param/report"})) return getPluginParameterReport(message);
-    if (msgAddressPattern.matches({"/plugin/params/report"})) return getPluginParametersReport(message);
-    if (msgAddressPattern.toString().startsWith("/plugin/sampler")) return handleSamplerMessage(message);
-    if (msgAddressPattern.matches({"/audiotrack/select"})) return selectAudioTrack(message);
-    if (msgAddressPattern.matches({"/audiotrack/select/return"})) return selectReturnTrack(message);
-    if (msgAddressPattern.matches({"/audiotrack/select/submix"})) return selectSubmixTrack(message);
-    if (msgAddressPattern.matches({"/audiotrack/set/db"})) return setTrackGain(message);
-    if (msgAddressPattern.matches({"/audiotrack/set/pan"})) return setTrackPan(message);
-    if (msgAddressPattern.matches({"/audiotrack/set/width"})) return setTrackWidth(message);
-    if (msgAddressPattern.matches({"/audiotrack/send/set/db"})) return ensureSend(message);
-    if (msgAddressPattern.matches({"/audiotrack/remove/clips"})) return removeAudioTrackClips(message);
-    if (msgAddressPattern.matches({"/audiotrack/remove/automation"})) return removeAudioTrackAutomation(message);
-    if (msgAddressPattern.matches({"/audiotrack/insert/wav"})) return insertWaveSample(message);
-    if (msgAddressPattern.matches({"/audiotrack/mute"})) return muteTrack(true);
-    if (msgAddressPattern.matches({"/audiotrack/unmute"})) return muteTrack(false);
-    if (msgAddressPattern.matches({"/audiotrack/region/render"})) return renderRegion(message);
-    if (msgAddressPattern.matches({"/file/save"})) return saveActiveEdit(message);
-    if (msgAddressPattern.matches({"/cd"})) return changeWorkingDirectory(message);
-    if (msgAddressPattern.toString().startsWith({"/transport"})) return handleTransportMessage(message);
-    if (msgAddressPattern.matches({"/clip/render"})) return renderClip(message);
-    if (msgAddressPattern.matches({"/clip/set/length"})) return setClipLength(message);
-    if (msgAddressPattern.matches({"/clip/select"})) return selectClip(message);
-    if (msgAddressPattern.matches({"/clip/trim/seconds"})) return trimClipBySeconds(message);
-    if (msgAddressPattern.matches({"/clip/source/offset/seconds"})) return offsetClipSourceInSeconds(message);
-    if (msgAddressPattern.matches({"/audioclip/set/db"})) return setClipDb(message);
-    if (msgAddressPattern.matches({"/audioclip/reverse"})) return reverseAudioClip(true);
-    if (msgAddressPattern.matches({"/audioclip/unreverse"})) return reverseAudioClip(false);
-    if (msgAddressPattern.matches({"/audioclip/fade/seconds"})) return audioClipFadeInOutSeconds(message);
-    if (msgAddressPattern.matches({"/tempo/set/"})) return setTempo(message);
-    if (msgAddressPattern.matches({"/content/clear"})) return clearContent(message);
+std::shared_ptr<const OscPacket> OscPacket::decode(const MemoryBlock& block) {
+    // The views must point into the packet's own copy of the data, so copy
+    // first, then decode.
+    auto packet = std::make_shared<OscPacket>();
+    const double startMs = Time::getMillisecondCounterHiRes();
+    packet->data = block;
+    OSCInputStream instream(packet->data.getData(), packet->data.getSize());
+    packet->element = instream.readElementViewWithKnownSize(packet->data.getSize());
+    packet->decodeMicroseconds = OscMetrics::elapsedMicroseconds(startMs);
+    return packet;
+}
 
-    printOscMessage(message);
-    OSCMessage error("/error");
-    constructReply(error, 1, "Unhandled Message");
-    return error;
+void FluidOscServer::enqueue(std::shared_ptr<const OscPacket> packet, ElementReplyFunc sendReply, StreamReplyFunc sendStream) {
+    pendingRequests.push_back({ packet, sendReply, sendStream });
+    handlePendingRequests();
+}
+
+void FluidOscServer::handlePendingRequests() {
+    while (!requestInProgress && !pendingRequests.empty()) {
+        PendingRequest request = pendingRequests.front();
+        pendingRequests.pop_front();
+
+        if (request.packet->element.isBundle) {
+            SelectedObjects obj = getSelectedObjects();
+            request.sendReply(handleOscBundle(request.packet->element, obj));
+            continue;
+        }
+
+        // While a deferred reply is outstanding, requestInProgress blocks the
+        // rest of the queue, so nothing else touches the edit in the meantime.
+        requestInProgress = true;
+        WeakReference<FluidOscServer> self(this);
+        ElementReplyFunc sendReply = request.sendReply;
+        const OscRoute* route = findRoute(request.packet->element.message.getAddress());
+        const String address = route ? route->address : String();
+        const double startMs = Time::getMillisecondCounterHiRes();
+        asyncReply = [self, sendReply, address, startMs](const OSCMessage& reply) {
+            // Only handlers (which have a route) can defer their reply
+            jassert(address.isNotEmpty());
+            recordHandled(address, startMs, reply);
+            sendReply(reply);
+            MessageManager::callAsync([self] {
+                if (FluidOscServer* server = self.get()) {
+                    server->requestInProgress = false;
+                    server->handlePendingRequests();
+                }
+            });
+        };
+        replyDeferred = false;
+        OSCMessage reply = handleOscMessage(request.packet->element.message, request.sendStream);
+        asyncReply = nullptr;
+        if (!replyDeferred) {
+            sendReply(reply);
+            requestInProgress = false;
+        }
+    }
+}
+
+AsyncReplyFunc FluidOscServer::deferReply() {
+    if (!asyncReply) return nullptr;
+    AsyncReplyFunc sendReply = asyncReply;
+    asyncReply = nullptr;
+    replyDeferred = true;
+    return sendReply;
+}
+
+OscMetrics::Address* FluidOscServer::getMetrics(const OSCElementView& element) const {
+    if (element.isBundle) return &OscMetrics::getInstance().get("#bundle");
+    const OscRoute* route = findRoute(element.message.getAddress());
+    return route ? &OscMetrics::getInstance().get(route->address) : nullptr;
+}
+
+const OscRoute* FluidOscServer::findRoute(const String& address) const {
+    auto found = routeIndex.find(address);
+    if (found != routeIndex.end()) return &routes[found->second];
+
+    if (address.containsAnyOf("*?[]{}")) {
+        try {
+            OSCAddressPattern pattern(address);
+            for (const auto& route : routes) {
+                if (pattern.matches(OSCAddress(route.address))) return &route;
+            }
+        } catch (const OSCFormatError&) {
+            return nullptr;
+        }
+    }
+
+    for (const auto& route : prefixRoutes) {
+        if (address.startsWith(route.address)) return &route;
+    }
+    return nullptr;
+}
+
+void FluidOscServer::addMethod(const String& address, OscHandlerFunc handler, bool needsActiveEdit) {
+    // Registering the same address twice is a programming error
+    jassert(routeIndex.find(address) == routeIndex.end());
+    routeIndex[address] = routes.size();
+    routes.push_back({ address, handler, needsActiveEdit });
+}
+
+void FluidOscServer::addPrefixMethod(const String& prefix, OscHandlerFunc handler, bool needsActiveEdit) {
+    prefixRoutes.push_back({ prefix, handler, needsActiveEdit });
+}
+
+OscHandlerFunc FluidOscServer::bind(OscMethod method) {
+    return [this, method](const OSCMessage& message) { return (this->*method)(message); };
+}
+
+OscViewHandlerFunc FluidOscServer::bind(OscViewMethod method) {
+    return [this, method](const OSCMessageView& message) { return (this->*method)(message); };
+}
+
+void FluidOscServer::addViewMethod(const String& address, OscViewHandlerFunc handler, bool needsActiveEdit) {
+    jassert(routeIndex.find(address) == routeIndex.end());
+    routeIndex[address] = routes.size();
+    routes.push_back({ address, nullptr, needsActiveEdit, handler });
+}
+
+void FluidOscServer::registerMethods() {
+    auto echo = [](const OSCMessage& message) {
+        printOscMessage(message);
+        return message;
+    };
+    addMethod("/test", echo, false);
+    addMethod("/print", echo, false);
+    addMethod("/file/activate", bind(&FluidOscServer::activateEditFile), false);
+    addMethod("/audiofile/report", bind(&FluidOscServer::getAudioFileReport), false);
+    addMethod("/metrics/report", bind(&FluidOscServer::getMetricsReport), false);
+
+    addMethod("/midiclip/insert/note", bind(&FluidOscServer::insertMidiNote));
+    addViewMethod("/midiclip/insert/notes", bind(&FluidOscServer::insertMidiNotes));
+    addMethod("/midiclip/select", bind(&FluidOscServer::selectMidiClip));
+    addMethod("/midiclip/clear", bind(&FluidOscServer::clearMidiClip));
+    addMethod("/plugin/select", bind(&FluidOscServer::selectPlugin));
+    addMethod("/plugin/param/set", bind(&FluidOscServer::setPluginParam));
+    addMethod("/plugin/param/set/at", bind(&FluidOscServer::setPluginParamAt));
+    addViewMethod("/plugin/param/set/curve", bind(&FluidOscServer::setPluginParamCurve));
+    addMethod("/plugin/sidechain/input/set", bind(&FluidOscServer::setPluginSideChainInput));
+    addMethod("/plugin/save", bind(&FluidOscServer::savePluginPreset));
+    addViewMethod("/plugin/load/trkpreset", bind(&FluidOscServer::loadPluginTrkpreset));
+    addMethod("/plugin/load", bind(&FluidOscServer::loadPluginPreset));
+    addMethod("/plugin/report", bind(&FluidOscServer::getPluginReport));
+    addMethod("/plugin/param/report", bind(&FluidOscServer::getPluginParameterReport));
+    addMethod("/plugin/params/report", bind(&FluidOscServer::getPluginParametersReport));
+    addPrefixMethod("/plugin/sampler", bind(&FluidOscServer::handleSamplerMessage));
+    addMethod("/audiotrack/select", bind(&FluidOscServer::selectAudioTrack));
+    addMethod("/audiotrack/select/return", bind(&FluidOscServer::selectReturnTrack));
+    addMethod("/audiotrack/select/submix", bind(&FluidOscServer::selectSubmixTrack));
+    addMethod("/audiotrack/set/db", bind(&FluidOscServer::setTrackGain));
+    addMethod("/audiotrack/set/pan", bind(&FluidOscServer::setTrackPan));
+    addMethod("/audiotrack/set/width", bind(&FluidOscServer::setTrackWidth));
+    addMethod("/audiotrack/send/set/db", bind(&FluidOscServer::ensureSend));
+    addMethod("/audiotrack/remove/clips", bind(&FluidOscServer::removeAudioTrackClips));
+    addMethod("/audiotrack/remove/automation", bind(&FluidOscServer::removeAudioTrackAutomation));
+    addMethod("/audiotrack/insert/wav", bind(&FluidOscServer::insertWaveSample));
+    addMethod("/audiotrack/mute", [this](const OSCMessage&) { return muteTrack(true); });
+    addMethod("/audiotrack/unmute", [this](const OSCMessage&) { return muteTrack(false); });
+    addMethod("/audiotrack/region/render", bind(&FluidOscServer::renderRegion));
+    addMethod("/file/save", bind(&FluidOscServer::saveActiveEdit));
+    addMethod("/cd", bind(&FluidOscServer::changeWorkingDirectory));
+    addPrefixMethod("/transport", bind(&FluidOscServer::handleTransportMessage));
+    addMethod("/clip/render", bind(&FluidOscServer::renderClip));
+    addMethod("/render/stems", bind(&FluidOscServer::renderStems));
+    addMethod("/audiotrack/region/stream", bind(&FluidOscServer::streamRegion));
+    addMethod("/clip/stream", bind(&FluidOscServer::streamClip));
+    addMethod("/clip/set/length", bind(&FluidOscServer::setClipLength));
+    addMethod("/clip/select", bind(&FluidOscServer::selectClip));
+    addMethod("/clip/trim/seconds", bind(&FluidOscServer::trimClipBySeconds));
+    addMethod("/clip/source/offset/seconds", bind(&FluidOscServer::offsetClipSourceInSeconds));
+    addMethod("/audioclip/set/db", bind(&FluidOscServer::setClipDb));
+    addMethod("/audioclip/reverse", [this](const OSCMessage&) { return reverseAudioClip(true); });
+    addMethod("/audioclip/unreverse", [this](const OSCMessage&) { return reverseAudioClip(false); });
+    addMethod("/audioclip/fade/seconds", bind(&FluidOscServer::audioClipFadeInOutSeconds));
+    // OSCAddressPattern and OSCMessageView::getAddress trim trailing slashes,
+    // so this also handles "/tempo/set/"
+    addMethod("/tempo/set", bind(&FluidOscServer::setTempo));
+    addMethod("/content/clear", bind(&FluidOscServer::clearContent));
 }
 
 OSCMessage FluidOscServer::selectSubmixTrack(const OSCMessage& message) {
@@ -152,7 +364,7 @@ OSCMessage FluidOscServer::selectSubmixTrack(const OSCMessage& message) {
         parentName = message[1].getString();
     }
 
-    selectedTrack = getOrCreateSubmixByName(activeCybrEdit->getEdit(), submixName, parentName);
+    selectedTrack = getOrCreateSubmixByName(activeCybrEdit->getEdit(), submixName, parentName, &activeCybrEdit->getTrackNameIndex());
     constructReply(reply, 0, "Submix selected: " + selectedTrack->getName());
     return reply;
 }
@@ -332,7 +544,7 @@ OSCMessage FluidOscServer::reverseAudioClip(bool reverse) {
         double maxValidLength = sourceLength - startInSource;
         jassert(maxValidLength > 0);
         if (length > maxValidLength && maxValidLength > 0) {
-            std::cout << "pre-reverse trim: " << maxValidLength - length << " " << audioClip->getOriginalFile().getFileName() << std::endl;
+            CYBR_LOG(info, osc, "pre-reverse trim: " << maxValidLength - length << " " << audioClip->getOriginalFile().getFileName());
             audioClip->setLength(maxValidLength, false);
         }
 
@@ -525,7 +737,16 @@ OSCMessage FluidOscServer::renderRegion(const OSCMessage& message) {
         range.start = startSeconds;
         range.end = endSeconds;
     }
-    renderTrackRegion(outputFile, *selectedTrack, range);
+
+    String cacheKey = RenderCache::createKey(*selectedTrack, range);
+    if (renderCache.reuse(cacheKey, outputFile)) {
+        constructReply(reply, 0, "Reused cached render: " + outputFile.getFullPathName());
+        return reply;
+    }
+
+    // te::Renderer must run on the message thread, so this blocks. Rendering
+    // here also keeps UDP messages from changing the edit mid-render.
+    if (renderTrackRegion(outputFile, *selectedTrack, range)) renderCache.add(cacheKey, outputFile);
 
     reply.addInt32(0);
     return reply;
@@ -563,11 +784,186 @@ OSCMessage FluidOscServer::renderClip(const juce::OSCMessage &message) {
     te::EditTimeRange range = selectedClip->getEditTimeRange();
     range.end += tail;
 
-    renderTrackRegion(outputFile, *track, range);
+    String cacheKey = RenderCache::createKey(*track, range);
+    if (renderCache.reuse(cacheKey, outputFile)) {
+        constructReply(reply, 0, "Reused cached render: " + outputFile.getFullPathName());
+        return reply;
+    }
+
+    if (renderTrackRegion(outputFile, *track, range)) renderCache.add(cacheKey, outputFile);
     reply.addInt32(0);
     return reply;
 }
 
+OSCMessage FluidOscServer::streamRegion(const OSCMessage& message) {
+    // Args
+    // 0 - (string, required) sample encoding: "f32", "s16" or "s24"
+    // 1 - (float, optional) start wholeNotes
+    // 2 - (float, optional) duration in wholeNotes
+    // An int argument sets the frames per block message (default = 8192).
+    // Like /audiotrack/region/render, but the audio is sent to the requesting
+    // connection as it is rendered (see RenderStream), and the reply's second
+    // argument is the number of frames sent.
+    OSCMessage reply("/audiotrack/region/stream/reply");
+    if (!selectedTrack) {
+        constructReply(reply, 1, "Cannot stream track region: No selected track");
+        return reply;
+    }
+
+    te::Edit& edit = selectedTrack->edit;
+    te::EditTimeRange range = edit.getTransport().getLoopRange();
+    if (message.size() >= 3 && message[1].isFloat32() && message[2].isFloat32()) {
+        double startBeats = message[1].getFloat32() * 4.0;
+        double endBeats = startBeats + message[2].getFloat32() * 4.0;
+        range.start = edit.tempoSequence.beatsToTime(startBeats);
+        range.end = edit.tempoSequence.beatsToTime(endBeats);
+    }
+    return streamTrackRegion(reply, *selectedTrack, range, message);
+}
+
+OSCMessage FluidOscServer::streamClip(const OSCMessage& message) {
+    // Args
+    // 0 - (string, required) sample encoding: "f32", "s16" or "s24"
+    // 1 - (float, optional) tail in seconds
+    // An int argument sets the frames per block message (default = 8192).
+    // Like /clip/render, but streamed. See streamRegion.
+    OSCMessage reply("/clip/stream/reply");
+    if (!selectedClip) {
+        constructReply(reply, 1, "Cannot stream clip: No clip selected");
+        return reply;
+    }
+
+    te::Track* track = selectedClip->getTrack();
+    if (!track) {
+        jassert(false);
+        constructReply(reply, 1, "Cannot stream clip: Failed to get clip's track");
+        return reply;
+    }
+
+    double tail = (message.size() >= 2 && message[1].isFloat32()) ? message[1].getFloat32() : 0;
+    te::EditTimeRange range = selectedClip->getEditTimeRange();
+    range.end += tail;
+    return streamTrackRegion(reply, *track, range, message);
+}
+
+OSCMessage FluidOscServer::streamTrackRegion(OSCMessage reply,
+                                             te::Track& track,
+                                             te::EditTimeRange range,
+                                             const OSCMessage& message) {
+    RenderStream::Encoding encoding;
+    if (!message.size() || !message[0].isString()) {
+        constructReply(reply, 1, "Cannot stream render: Missing encoding");
+        return reply;
+    }
+    if (!RenderStream::parseEncoding(message[0].getString(), encoding)) {
+        constructReply(reply, 1, "Cannot stream render: Unknown encoding: " + message[0].getString());
+        return reply;
+    }
+    int framesPerBlock = 8192;
+    for (int i = 1; i < message.size(); i++) {
+        if (message[i].isInt32()) {
+            framesPerBlock = jmax(1, message[i].getInt32());
+            break;
+        }
+    }
+
+    StreamReplyFunc sendStream = getReplyStream();
+    if (!sendStream) {
+        constructReply(reply, 1, "Cannot stream render: Streaming is only available to pipelined IPC requests outside of bundles");
+        return reply;
+    }
+
+    const String address = reply.getAddressPattern().toString();
+    auto createReply = [address](int64 numFrames) {
+        OSCMessage finished(address);
+        if (numFrames == RenderStream::sendFailed) {
+            finished.addInt32(1);
+            finished.addString("Cannot stream render: The client did not read the stream in time");
+        } else if (numFrames < 0) {
+            finished.addInt32(1);
+            finished.addString("Cannot stream render: Render failed");
+        } else {
+            finished.addInt32(0);
+            finished.addInt32((int32)numFrames);
+        }
+        return finished;
+    };
+
+    // te::Renderer must run on the message thread, like renderRegion. Blocks
+    // are sent while it renders, and sendStream blocks if the connection
+    // falls behind, so a slow client does not buffer the whole render. If the
+    // client stops reading, sendStream gives up and the render stops.
+    return createReply(RenderStream::renderTrackRegion(track, range, encoding, framesPerBlock, sendStream));
+}
+
+OSCMessage FluidOscServer::renderStems(const juce::OSCMessage &message) {
+    // Args
+    // 0 - (string, required) output directory. Stems are named after tracks
+    // 1 - (float, optional) start wholeNotes
+    // 2 - (float, optional) duration in wholeNotes
+    // Any other string arguments are names of tracks to render. If there are
+    // none, render every audio track. If both 1 and 2 are floats, render that
+    // time range. Otherwise, render the whole edit.
+    OSCMessage reply("/render/stems/reply");
+    if (message.size() < 1 || !message[0].isString()) {
+        String errorString = "Cannot render stems: Missing output directory";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    te::Edit& edit = activeCybrEdit->getEdit();
+    File directory = edit.filePathResolver(message[0].getString());
+    if (!directory.createDirectory()) {
+        String errorString = "Cannot render stems: Failed to create directory: " + directory.getFullPathName();
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    te::EditTimeRange range(0, edit.getLength());
+    if (message.size() >= 3 && message[1].isFloat32() && message[2].isFloat32()) {
+        double startBeats = message[1].getFloat32() * 4.0;
+        double endBeats = startBeats + message[2].getFloat32() * 4.0;
+        range.start = edit.tempoSequence.beatsToTime(startBeats);
+        range.end = edit.tempoSequence.beatsToTime(endBeats);
+    }
+
+    Array<te::Track*> tracks;
+    for (int i = 1; i < message.size(); i++) {
+        if (message[i].isString()) {
+            String trackName = message[i].getString();
+            te::Track* found = nullptr;
+            for (auto track : te::getAllTracks(edit)) {
+                if (track->getName() == trackName) {
+                    found = track;
+                    break;
+                }
+            }
+            if (!found) {
+                String errorString = "Cannot render stems: Track not found: " + trackName;
+                constructReply(reply, 1, errorString);
+                return reply;
+            }
+            tracks.add(found);
+        }
+    }
+    if (tracks.isEmpty()) {
+        for (auto track : te::getAudioTracks(edit)) tracks.add(track);
+    }
+
+    if (tracks.isEmpty()) {
+        constructReply(reply, 1, "Cannot render stems: No tracks to render");
+        return reply;
+    }
+
+    // Blocks until every stem is rendered. The stems are rendered by worker
+    // processes at the same time (see StemRenderJob).
+    StemRenderJob job(edit, tracks, directory, range);
+    int successes = job.render();
+    reply.addInt32(successes == (int)job.getStems().size() ? 0 : 1);
+    reply.addString(JSON::toString(job.getReport(), true));
+    return reply;
+}
+
 OSCMessage FluidOscServer::saveActiveEdit(const juce::OSCMessage &message) {
     OSCMessage reply("/file/save/reply");
     if (!activeCybrEdit) {
@@ -593,18 +989,39 @@ OSCMessage FluidOscServer::saveActiveEdit(const juce::OSCMessage &message) {
         if (arg1.startsWith("a")) mode = SamplePathMode::absolute;
         else if (arg1.startsWith("r")) mode = SamplePathMode::relative;
         else if (arg1.startsWith("d")) mode = SamplePathMode::decide;
-        else std::cout << "Save - unknown SamplePathMode: " << arg1 << std::endl;
+        else CYBR_LOG(info, osc, "Save - unknown SamplePathMode: " << arg1);
+    }
+
+    const double startMs = Time::getMillisecondCounterHiRes();
+
+    // When the request allows it, write .tracktionedit files on a background
+    // thread. Only copying the state blocks the message thread.
+    if (file.hasFileExtension(".tracktionedit")) {
+        if (AsyncReplyFunc sendReply = deferReply()) {
+            activeCybrEdit->saveActiveEditAsync(file, mode, backgroundJobs, [file, startMs, sendReply](bool success) {
+                double ms = Time::getMillisecondCounterHiRes() - startMs;
+                String replyString = (success ? "Saved " : "Failed to save ")
+                    + file.getFullPathName() + " in " + String(ms, 1) + "ms";
+                CYBR_LOG(info, osc, replyString);
+                OSCMessage asyncReply("/file/save/reply");
+                asyncReply.addInt32(success ? 0 : 1);
+                asyncReply.addString(replyString);
+                sendReply(asyncReply);
+            });
+            return reply;
+        }
     }
 
     activeCybrEdit->saveActiveEdit(file, mode);
-    reply.addInt32(0);
+    double ms = Time::getMillisecondCounterHiRes() - startMs;
+    constructReply(reply, 0, "Saved " + file.getFullPathName() + " in " + String(ms, 1) + "ms");
     return reply;
 }
 
 OSCMessage FluidOscServer::activateEditFile(File file, bool forceEmptyEdit) {
     OSCMessage reply("/file/activate/reply");
     if (forceEmptyEdit || !file.existsAsFile()) {
-        std::cout << "Creating new edit: " << file.getFullPathName() << std::endl;
+        CYBR_LOG(info, osc, "Creating new edit: " << file.getFullPathName());
         activeCybrEdit = std::make_unique<CybrEdit>(createEmptyEdit(file, te::Engine::getInstance(), te::Edit::forEditing));
         // This is a little hacky, but I want the engine to stop putting
         // "Track 1" in everything. Note that there may be other places that
@@ -613,8 +1030,12 @@ OSCMessage FluidOscServer::activateEditFile(File file, bool forceEmptyEdit) {
         activeCybrEdit->removeTracksNamed("Track 1");
         if (!file.existsAsFile()) activeCybrEdit->saveActiveEdit(file);
     } else {
-        std::cout << "Loading edit: " << file.getFullPathName() << std::endl;
-        activeCybrEdit = std::make_unique<CybrEdit>(createEdit(file, te::Engine::getInstance(), te::Edit::forEditing));
+        CYBR_LOG(info, osc, "Loading edit: " << file.getFullPathName());
+        bool snapshotIsFresh = hasFreshEditSnapshot(file);
+        EditFileStamp stamp = EditFileStamp::of(file);
+        activeCybrEdit = std::make_unique<CybrEdit>(createEdit(file, te::Engine::getInstance(), te::Edit::forEditing, true));
+        // Write a binary snapshot, so the next activation can skip parsing XML
+        if (!snapshotIsFresh) writeEditSnapshotBinary(activeCybrEdit->getEdit().state, getEditSnapshotFile(file), stamp);
     }
     return reply;
 }
@@ -629,7 +1050,7 @@ OSCMessage FluidOscServer::activateEditFile(const juce::OSCMessage &message) {
 
     File file = File::getCurrentWorkingDirectory().getChildFile(message[0].getString());
     if (!file.hasFileExtension(".tracktionedit")) {
-        std::cout << "WARNING: /file/activate argument does not have .tracktionedit extention: " << file.getFileName() << std::endl;
+        CYBR_LOG(warning, osc, "WARNING: /file/activate argument does not have .tracktionedit extention: " << file.getFileName());
     }
 
     bool forceEmptyEdit = (message.size() >= 2 && message[1].isInt32()) ? message[1].getInt32() : false;
@@ -685,7 +1106,7 @@ OSCMessage FluidOscServer::selectAudioTrack(const juce::OSCMessage& message) {
     }
 
     String trackName = message[0].getString();
-    selectedTrack = getOrCreateAudioTrackByName(activeCybrEdit->getEdit(), trackName, submixName);
+    selectedTrack = getOrCreateAudioTrackByName(activeCybrEdit->getEdit(), trackName, submixName, &activeCybrEdit->getTrackNameIndex());
 
     reply.addInt32(0);
     return reply;
@@ -720,7 +1141,7 @@ OSCMessage FluidOscServer::selectReturnTrack(const juce::OSCMessage &message) {
         return reply;
     }
 
-    selectedTrack = getOrCreateAudioTrackByName(activeCybrEdit->getEdit(), busName);
+    selectedTrack = getOrCreateAudioTrackByName(activeCybrEdit->getEdit(), busName, String(), &activeCybrEdit->getTrackNameIndex());
     jassert(selectedTrack); // I believe this will always return a track
 
     // Look through plugins on the track, see if it already has an AuxReturnPlugin
@@ -856,7 +1277,7 @@ OSCMessage FluidOscServer::selectPlugin(const OSCMessage& message) {
         constructReply(reply, 1, errorString);
         return reply;
     }
-    selectedPlugin = getOrCreatePluginByName(*selectedTrack, pluginName, pluginFormat, index);
+    selectedPlugin = getOrCreatePluginByName(*selectedTrack, pluginName, pluginFormat, index, &getKnownPluginIndex());
     reply.addInt32(0);
     return reply;
 }
@@ -928,6 +1349,45 @@ OSCMessage FluidOscServer::setPluginParam(const OSCMessage& message) {
     return reply;
 }
 
+KnownPluginIndex& FluidOscServer::getKnownPluginIndex() {
+    if (!knownPluginIndex) {
+        auto& list = te::Engine::getInstance().getPluginManager().knownPluginList;
+        knownPluginIndex = std::make_unique<KnownPluginIndex>(list);
+    }
+    return *knownPluginIndex;
+}
+
+te::AutomatableParameter::Ptr FluidOscServer::findSelectedPluginParam(const String& paramName) {
+    jassert(selectedPlugin);
+    te::AutomatableParameter::Ptr foundParam;
+    if (auto rack = dynamic_cast<te::RackInstance*>(selectedPlugin)) {
+        auto rackType = selectedTrack->edit.getRackList().getRackTypeForID(rack->rackTypeID);
+        for (auto macro : rackType->macroParameterList.getMacroParameters()) {
+            if (macro->macroName == paramName) { // CAUTION: this is case sensitive, while below is insensitive
+                foundParam = macro;
+                break;
+            }
+        }
+    }
+
+    // Iterate over the parameter list in reverse. This is a slightly hacky way
+    // to dodge the "Dry Level" and "Wet Level" parameters that tracktion adds
+    // to all plugins. Some external plugins may have their own Dry/Wet level
+    // params. Because the tracktion versions always come first, we only find
+    // them if the plugin does not provide its own version.
+    if (!foundParam) {
+        for (int i = selectedPlugin->getNumAutomatableParameters() - 1; i >= 0; i--) {
+            te::AutomatableParameter::Ptr param = selectedPlugin->getAutomatableParameter(i);
+            if (param->paramName.equalsIgnoreCase(paramName)) {
+                foundParam = param;
+                break;
+            }
+        }
+    }
+
+    return foundParam;
+}
+
 OSCMessage FluidOscServer::setPluginParamAt(const OSCMessage& message) {
     OSCMessage reply("/plugin/param/set/at/reply");
     if (message.size() > 5 ||
@@ -952,7 +1412,7 @@ OSCMessage FluidOscServer::setPluginParamAt(const OSCMessage& message) {
     bool isNormalized = message[4].getString() == "normalized";
     if (isNormalized){
         if (paramValue > 1 || paramValue < 0) {
-            std::cout << "Setting parameter " + paramName + ": normalized value clamped" << std::endl;
+            CYBR_LOG(info, osc, "Setting parameter " + paramName + ": normalized value clamped");
         }
 
         if (paramValue > 1) paramValue = 1;
@@ -969,37 +1429,12 @@ OSCMessage FluidOscServer::setPluginParamAt(const OSCMessage& message) {
 
     float curveValue = message[3].getFloat32();
     if (curveValue > 1 || curveValue < -1) {
-        std::cout << "Setting parameter " + paramName + "curve value clamped" << std::endl;
+        CYBR_LOG(info, osc, "Setting parameter " + paramName + "curve value clamped");
         if (curveValue < -1) curveValue = -1;
         else if (curveValue > 1) curveValue = 1;
     }
 
-    te::AutomatableParameter::Ptr foundParam;
-    if (auto rack = dynamic_cast<te::RackInstance*>(selectedPlugin)) {
-        auto rackType = selectedTrack->edit.getRackList().getRackTypeForID(rack->rackTypeID);
-        for (auto macro : rackType->macroParameterList.getMacroParameters()) {
-            if (macro->macroName == paramName) { // CAUTION: this is case sensitive, while below is insensitive
-                foundParam = macro;
-                break;
-            }
-        }
-    }
-
-    // Iterate over the parameter list in reverse. This is a slightly hacky way
-    // to dodge the "Dry Level" and "Wet Level" parameters that tracktion adds
-    // to all plugins. Some external plugins may have their own Dry/Wet level
-    // params. Because the tracktion versions always come first, we only find
-    // them if the plugin does not provide its own version.
-    if (!foundParam) {
-        for (int i = selectedPlugin->getNumAutomatableParameters() - 1; i >= 0; i--) {
-            te::AutomatableParameter::Ptr param = selectedPlugin->getAutomatableParameter(i);
-            if (param->paramName.equalsIgnoreCase(paramName)) {
-                foundParam = param;
-                break;
-            }
-        }
-    }
-
+    te::AutomatableParameter::Ptr foundParam = findSelectedPluginParam(paramName);
     if (foundParam) {
         setParamAutomationPoint(foundParam, paramValue, changeWholeNotes, curveValue, isNormalized);
         String replyString = "set " + paramName
@@ -1013,6 +1448,92 @@ OSCMessage FluidOscServer::setPluginParamAt(const OSCMessage& message) {
     return reply;
 }
 
+OSCMessage FluidOscServer::setPluginParamCurve(const OSCMessageView& message) {
+    // Args. Each blob is a column of packed big-endian float32 values.
+    // 0 - (string, required) parameter name
+    // 1 - (blob, required) parameter values
+    // 2 - (blob, required) times in whole notes
+    // 3 - (blob, optional) curve values from -1 to 1 (default = 0, linear)
+    // 4 - (string, optional) "normalized" or "explicit" (default = normalized)
+    OSCMessage reply("/plugin/param/set/curve/reply");
+    if (message.size() < 3 ||
+        !message[0].isString() ||
+        !message[1].isBlob() ||
+        !message[2].isBlob()) {
+        String errorString = "Setting parameter curve failed. Incorrect arguments. (sbb[b][s], expected).";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    if (!selectedPlugin) {
+        String errorString = "Setting parameter curve failed: No selected plugin";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    String paramName = message[0].getString();
+    bool isNormalized = true;
+    std::vector<float> paramValues;
+    std::vector<float> times;
+    std::vector<float> curveValues;
+    bool blobsOk = unpackFloat32Blob(message[1].getBlob(), paramValues)
+        && unpackFloat32Blob(message[2].getBlob(), times);
+    for (int i = 3; i < message.size(); i++) {
+        if (message[i].isBlob()) {
+            blobsOk = blobsOk && unpackFloat32Blob(message[i].getBlob(), curveValues);
+        } else if (message[i].isString()) {
+            String mode = message[i].getString();
+            if (mode == "normalized") isNormalized = true;
+            else if (mode == "explicit") isNormalized = false;
+            else {
+                String errorString = "Setting parameter " + paramName + " curve failed: Unknown mode: " + mode
+                + " (expected \"normalized\" or \"explicit\")";
+                constructReply(reply, 1, errorString);
+                return reply;
+            }
+        }
+    }
+    if (!blobsOk) {
+        String errorString = "Setting parameter " + paramName + " curve failed: blob size is not a multiple of 4 bytes";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    const size_t count = paramValues.size();
+    if (times.size() != count || (curveValues.size() && curveValues.size() != count)) {
+        String errorString = "Setting parameter " + paramName + " curve failed: blobs have different numbers of values";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!std::isfinite(times[i]) || times[i] < 0) {
+            String errorString = "Setting parameter " + paramName
+            + " curve failed. Times have to be positive numbers.";
+            constructReply(reply, 1, errorString);
+            return reply;
+        }
+        if (!std::isfinite(paramValues[i]) || (curveValues.size() && !std::isfinite(curveValues[i]))) {
+            String errorString = "Setting parameter " + paramName
+            + " curve failed: invalid value at index " + String((int)i);
+            constructReply(reply, 1, errorString);
+            return reply;
+        }
+        if (isNormalized) paramValues[i] = jlimit(0.f, 1.f, paramValues[i]);
+    }
+    for (auto& curveValue : curveValues) curveValue = jlimit(-1.f, 1.f, curveValue);
+
+    te::AutomatableParameter::Ptr foundParam = findSelectedPluginParam(paramName);
+    if (!foundParam) {
+        constructReply(reply, 1, "Failed to find param named: " + paramName);
+        return reply;
+    }
+
+    setParamAutomationCurve(foundParam, paramValues, times, curveValues, isNormalized);
+    constructReply(reply, 0, "set " + String((int)count) + " automation points on " + paramName);
+    return reply;
+}
+
 juce::OSCMessage FluidOscServer::setTrackWidth(const juce::OSCMessage& message) {
     OSCMessage reply("/audiotrack/set/width/reply");
 
@@ -1042,27 +1563,16 @@ juce::OSCMessage FluidOscServer::setTrackWidth(const juce::OSCMessage& message)
     }
 
     float paramValue = message[0].getFloat32() * 0.5 + 0.5;
-    auto plugin = getOrCreatePluginByName(*selectedTrack, "cybr-width", "tracktion");
-    auto rack = dynamic_cast<te::RackInstance*>(plugin);
-    jassert(rack);
+    auto widthPlugin = ensureWidthPlugin(*selectedTrack);
+    if (!widthPlugin) {
+        constructReply(reply, 1, "Cannot set track width: Failed to create cybr-width plugin");
+        return reply;
+    }
 
     if (isAutomation) {
-        for (auto macro : selectedTrack->macroParameterList.getMacroParameters()) {
-            if (macro->macroName == "width automation") {
-                // Charles: I'm a little confused about the "macro" data type.
-                // It seems like it is a regular pointer, while setParamAutomationPoint
-                // accepts a juce style smart pointer. Does this mean that it
-                // might automatically cast to a smart points, causeing it to be
-                // erroneously freed when the smart pointer gets deleted?
-                setParamAutomationPoint(macro, paramValue, timeInWholeNotes, curveValue);
-            }
-        }
+        setParamAutomationPoint(widthPlugin->widthAutomation, paramValue, timeInWholeNotes, curveValue);
     } else  {
-        for (auto macro : selectedTrack->macroParameterList.getMacroParameters()) {
-            if (macro->macroName == "width") {
-                macro->setParameter(paramValue, juce::NotificationType::sendNotificationSync);
-            }
-        }
+        widthPlugin->width->setNormalisedParameter(paramValue, juce::NotificationType::sendNotificationSync);
     }
 
     reply.addInt32(0);
@@ -1092,10 +1602,10 @@ OSCMessage FluidOscServer::setPluginSideChainInput(const OSCMessage& message) {
     String inputTrackname = message[0].getString();
     te::AudioTrack* inputTrack = getOrCreateAudioTrackByName(selectedPlugin->edit, inputTrackname);
     selectedPlugin->setSidechainSourceID(inputTrack->itemID);
-    std::cout << "Side chain input: " << inputTrack->getName() << std::endl;
+    CYBR_LOG(info, osc, "Side chain input: " << inputTrack->getName());
 
     if (auto compressor = dynamic_cast<te::CompressorPlugin*>(selectedPlugin)) {
-        std::cout << "NOTE: when enabling a side chain in put on the internal compressor plugin, the side chain will be enabled by default. " << std::endl;
+        CYBR_LOG(warning, osc, "NOTE: when enabling a side chain in put on the internal compressor plugin, the side chain will be enabled by default. ");
         compressor->useSidechainTrigger = true;
     }
 
@@ -1193,7 +1703,7 @@ OSCMessage FluidOscServer::savePluginPreset(const juce::OSCMessage& message) {
     return reply;
 }
 
-OSCMessage FluidOscServer::loadPluginTrkpreset(const juce::OSCMessage &message) {
+OSCMessage FluidOscServer::loadPluginTrkpreset(const OSCMessageView& message) {
     OSCMessage reply("/plugin/load/trkpreset/reply");
     if (!selectedTrack) {
         String errorString = "Cannot load plugin preset: No audio track selected";
@@ -1207,8 +1717,8 @@ OSCMessage FluidOscServer::loadPluginTrkpreset(const juce::OSCMessage &message)
         return reply;
     }
 
-    MemoryBlock blob = message[0].getBlob();
-    String string = String::createStringFromData(blob.getData(), (int)blob.getSize());
+    const OSCDataView& blob = message[0].getBlob();
+    String string = String::createStringFromData(blob.data, (int)blob.size);
     std::unique_ptr<XmlElement> xml = parseXML(string);
     if (!xml) {
         String errorString = "Cannot load trkpreset data: XML parser error";
@@ -1256,7 +1766,7 @@ OSCMessage FluidOscServer::loadPluginPreset(const juce::OSCMessage& message) {
         // Look in the Cybr Search Path.
         file = CybrSearchPath(CYBR_PRESET).find(filename);
         if (file != File()) filename = file.getFullPathName(); // Found it!
-        else std::cout << "Warning: preset file not found: " << filename << std::endl;
+        else CYBR_LOG(warning, osc, "Warning: preset file not found: " << filename);
     }
 
     ValueTree v = loadXmlFile(file);
@@ -1403,6 +1913,83 @@ OSCMessage FluidOscServer::insertMidiNote(const juce::OSCMessage& message) {
     return reply;
 }
 
+OSCMessage FluidOscServer::insertMidiNotes(const OSCMessageView& message) {
+    // Args. Each blob is a column of packed big-endian 32 bit values, and all
+    // the columns must have the same number of values.
+    // 0 - (blob, required) note numbers (int32)
+    // 1 - (blob, required) start times in whole notes (float32)
+    // 2 - (blob, required) durations in whole notes (float32)
+    // 3 - (blob, optional) velocities (int32, default = 64)
+    OSCMessage reply("/midiclip/insert/notes/reply");
+    if (!selectedClip) {
+        String errorString = "Cannot insert midi notes: No clip selected.";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    auto selectedMidiClip = dynamic_cast<te::MidiClip*>(selectedClip);
+    if (!selectedMidiClip) {
+        String errorString = "Cannot insert midi notes: selected clip is not a midi clip";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    if (message.size() < 3 || !message[0].isBlob() || !message[1].isBlob() || !message[2].isBlob()) {
+        String errorString = "Cannot insert midi notes: expected note, start, and duration blobs";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    std::vector<int> noteNumbers;
+    std::vector<float> starts;
+    std::vector<float> durations;
+    std::vector<int> velocities;
+    if (!unpackInt32Blob(message[0].getBlob(), noteNumbers)
+        || !unpackFloat32Blob(message[1].getBlob(), starts)
+        || !unpackFloat32Blob(message[2].getBlob(), durations)
+        || (message.size() >= 4 && message[3].isBlob() && !unpackInt32Blob(message[3].getBlob(), velocities))) {
+        String errorString = "Cannot insert midi notes: blob size is not a multiple of 4 bytes";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    const size_t count = noteNumbers.size();
+    if (starts.size() != count || durations.size() != count || (velocities.size() && velocities.size() != count)) {
+        String errorString = "Cannot insert midi notes: blobs have different numbers of values";
+        constructReply(reply, 1, errorString);
+        return reply;
+    }
+
+    // Validate everything before touching the clip, so that a bad batch does
+    // not leave half of its notes behind.
+    for (size_t i = 0; i < count; i++) {
+        if (noteNumbers[i] < 0 || noteNumbers[i] > 127
+            || !std::isfinite(starts[i]) || !std::isfinite(durations[i])
+            || starts[i] < 0 || durations[i] <= 0) {
+            String errorString = "Cannot insert midi notes: invalid note at index " + String((int)i);
+            constructReply(reply, 1, errorString);
+            return reply;
+        }
+    }
+
+    // Build the NOTE children the same way te::MidiList::addNote does, and
+    // append them directly to the sequence state.
+    ValueTree sequenceState = selectedMidiClip->getSequence().state;
+    for (size_t i = 0; i < count; i++) {
+        int velocity = velocities.size() ? jlimit(0, 127, velocities[i]) : 64;
+        sequenceState.appendChild(ValueTree(te::IDs::NOTE, {
+            { te::IDs::p, noteNumbers[i] },
+            { te::IDs::b, starts[i] * 4.0 },
+            { te::IDs::l, durations[i] * 4.0 },
+            { te::IDs::v, velocity },
+            { te::IDs::c, 0 }
+        }), nullptr);
+    }
+
+    constructReply(reply, 0, "Inserted " + String((int)count) + " midi notes");
+    return reply;
+}
+
 OSCMessage FluidOscServer::insertWaveSample(const juce::OSCMessage& message){
     OSCMessage reply("/audiotrack/insert/wav/reply");
     if(!selectedTrack){
@@ -1453,18 +2040,19 @@ OSCMessage FluidOscServer::insertWaveSample(const juce::OSCMessage& message){
         // Look in the sample search path.
         file = CybrSearchPath(CYBR_SAMPLE).find(filePath);
         if (file != File()) filePath = file.getFullPathName(); // Found it!
-        else std::cout << "Cannot insert wave file: File not found: " << filePath << std::endl;
+        else CYBR_LOG(error, osc, "Cannot insert wave file: File not found: " << filePath);
     }
 
-    te::AudioFile audiofile(selectedTrack->edit.engine, file);
-    if(!audiofile.isValid() || audiofile.isNull()){
+    // The same sample is often inserted many times, so avoid re-reading it
+    AudioFileCache::Info audiofile = AudioFileCache::getInstance().get(file);
+    if(!audiofile.isValid()){
         String errorString = "Cannot insert wave file: Must be valid audio file.";
         constructReply(reply, 1, errorString);
         return reply;
     }
 
     if (auto* audioTrack = dynamic_cast<te::AudioTrack*>(selectedTrack)) {
-        te::EditTimeRange timeRange = te::EditTimeRange(startSeconds, startSeconds+audiofile.getLength());
+        te::EditTimeRange timeRange = te::EditTimeRange(startSeconds, startSeconds+audiofile.getLengthSeconds());
         te::ClipPosition pos;
         pos.time = timeRange;
         te::WaveAudioClip::Ptr c = audioTrack->insertWaveClip(clipName, file, pos, false);
@@ -1510,8 +2098,8 @@ OSCMessage FluidOscServer::setTrackGain(const OSCMessage& message) {
     }
 
     if (isAutomation) {
-        getOrCreatePluginByName(*selectedTrack, "volume", "tracktion", 1);
-        auto plugin = getOrCreatePluginByName(*selectedTrack, "volume", "tracktion", 0);
+        getOrCreatePluginByName(*selectedTrack, "volume", "tracktion", 1, &getKnownPluginIndex());
+        auto plugin = getOrCreatePluginByName(*selectedTrack, "volume", "tracktion", 0, &getKnownPluginIndex());
         if (auto volumePlugin = dynamic_cast<te::VolumeAndPanPlugin*>(plugin)) {
             float paramValue = te::decibelsToVolumeFaderPosition(gainDb);
             setParamAutomationPoint(volumePlugin->volParam, paramValue, timeInWholeNotes, curveValue, false);
@@ -1560,13 +2148,10 @@ OSCMessage FluidOscServer::setTrackPan(const OSCMessage& message) {
     }
 
     if (isAutomation) {
-        ensureWidthRack(*selectedTrack);
-        for (auto macro : selectedTrack->macroParameterList.getMacroParameters()) {
-            if (macro->macroName == "pan automation") {
-                setParamAutomationPoint(macro, panValue * 0.5 + 0.5, timeInWholeNotes, curveValue);
-                reply.addInt32(0);
-                return reply;
-            }
+        if (auto panMacro = ensurePanAutomationMacro(*selectedTrack)) {
+            setParamAutomationPoint(panMacro, panValue * 0.5 + 0.5, timeInWholeNotes, curveValue);
+            reply.addInt32(0);
+            return reply;
         }
     } else if (auto volumePlugin = selectedTrack->pluginList.getPluginsOfType<te::VolumeAndPanPlugin>().getLast()) {
         volumePlugin->setPan(panValue);
@@ -1574,7 +2159,7 @@ OSCMessage FluidOscServer::setTrackPan(const OSCMessage& message) {
         return reply;
     }
 
-    String errorString = "Cannot set track gain: Track is missing volume plugin or cybr rack.";
+    String errorString = "Cannot set track pan: Track is missing volume plugin.";
     constructReply(reply, 1, errorString);
     return reply;
 }
@@ -1669,7 +2254,7 @@ OSCMessage FluidOscServer::handleSamplerMessage(const OSCMessage &message) {
             // Look in the sample search path.
             file = CybrSearchPath(CYBR_SAMPLE).find(filePath);
             if (file != File()) filePath = file.getFullPathName(); // Found it!
-            else std::cout << "Warning: sampler trying to add sampler sound, but file not found: " << filePath << std::endl;
+            else CYBR_LOG(warning, osc, "Warning: sampler trying to add sampler sound, but file not found: " << filePath);
         }
 
         sampler->addSound(filePath, soundName, 0, 0, gain);
@@ -1694,10 +2279,10 @@ OSCMessage FluidOscServer::handleTransportMessage(const OSCMessage& message) {
 
     const OSCAddressPattern pattern = message.getAddressPattern();
     if (pattern.matches({"/transport/play"})) {
-        std::cout << "Play!" << std::endl;
+        CYBR_LOG(info, osc, "Play!");
         transport.play(false);
     } else if (pattern.matches({"/transport/stop"})) {
-        std::cout << "Stop!" << std::endl;
+        CYBR_LOG(info, osc, "Stop!");
         transport.stop(false, false);
     } else if (pattern.matches({"/transport/to/seconds"})) {
         if (message.size() < 1 || !message[0].isFloat32()){
@@ -1730,7 +2315,7 @@ OSCMessage FluidOscServer::handleTransportMessage(const OSCMessage& message) {
 
         if (durationBeats == 0) {
             // To disable looping specify duration of 0
-            std::cout << "Looping disabled!" << std::endl;
+            CYBR_LOG(info, osc, "Looping disabled!");
             transport.looping.setValue(false, nullptr);
             reply.addInt32(0);
             return reply;
@@ -1740,7 +2325,7 @@ OSCMessage FluidOscServer::handleTransportMessage(const OSCMessage& message) {
         if (range != te::EditTimeRange(startSeconds, endSeconds)) {
             if (range.getStart() != startSeconds) transport.setLoopIn(startSeconds);
             if (range.getEnd() != endSeconds) transport.setLoopOut(endSeconds);
-            std::cout << "Looping start|length: " << startBeats << "|" << endBeats << std::endl;
+            CYBR_LOG(info, osc, "Looping start|length: " << startBeats << "|" << endBeats);
         }
         // If looping was previously disabled, setting looping to true seems to
         // move the playhead to the start of the loop. This surprised me, but is
@@ -1755,6 +2340,12 @@ OSCMessage FluidOscServer::handleTransportMessage(const OSCMessage& message) {
 };
 
 OSCMessage FluidOscServer::getAudioFileReport(const OSCMessage& message) {
+    // Args
+    // 0... - (string) one or more file paths
+    // With one path, the reply JSON is the report for that file. With more,
+    // it is an array of reports in the same order, and files that cannot be
+    // found or read get a report with an "error" property. The headers of
+    // files that are not cached yet are read in parallel.
     OSCMessage reply("/audiofile/report/reply");
 
     if (!message.size()) {
@@ -1762,48 +2353,88 @@ OSCMessage FluidOscServer::getAudioFileReport(const OSCMessage& message) {
         return reply;
     }
 
-    if (!message[0].isString()) {
-        constructReply(reply, 1, "Cannot get audio file report: first argument must be a filename string");
-        return reply;
+    for (const auto& arg : message) {
+        if (!arg.isString()) {
+            constructReply(reply, 1, "Cannot get audio file report: arguments must be filename strings");
+            return reply;
+        }
     }
 
-    {
-        const String filePath = message[0].getString();
-        File file;
-        // The default filePathResolver checks for an absolute file, then looks
-        // in the relative to the edit file directory (using edit.editFileRetriever)
-        if (File::isAbsolutePath(filePath))   file = File(filePath);
-        if (file == File() && activeCybrEdit) file = activeCybrEdit->getEdit().filePathResolver(filePath);
-        if (file == File())                   file = CybrSearchPath(CYBR_SAMPLE).find(filePath);
-        if (file == File()) {
+    Array<File> files;
+    for (const auto& arg : message) files.add(findAudioFile(arg.getString()));
+    AudioFileCache& cache = AudioFileCache::getInstance();
+    cache.prewarm(files, SystemStats::getNumCpus());
+
+    if (message.size() == 1) {
+        if (files[0] == File()) {
             constructReply(reply, 1, "Cannot get audio file report: file not found");
             return reply;
         }
-
-        juce::DynamicObject::Ptr report = new DynamicObject();
-        std::unique_ptr<juce::AudioFormatReader> reader;
-        reader.reset(te::Engine::getInstance()
-            .getAudioFileFormatManager()
-            .readFormatManager
-            .createReaderFor(file));
-        if (reader)
-        {
-            report->setProperty("format", reader->getFormatName());
-            report->setProperty("lengthSeconds", reader->lengthInSamples / reader->sampleRate );
-            report->setProperty("lengthSamples", reader->lengthInSamples);
-            report->setProperty("sampleRate", reader->sampleRate);
-            report->setProperty("absolutePath", file.getFullPathName());
-            report->setProperty("givenPath", filePath);
-            report->setProperty("numChannels", int(reader->numChannels));
-            report->setProperty("bitDepth", int(reader->bitsPerSample));
-            constructReply(reply, 0, JSON::toString(report.get(), true));
-            return reply;
-        } else {
+        AudioFileCache::Info info = cache.get(files[0]);
+        if (!info.isValid()) {
             constructReply(reply, 1, "Cannot get audio file report: failed to read file");
             return reply;
         }
+        var report = createAudioFileReport(message[0].getString(), files[0], info);
+        constructReply(reply, 0, JSON::toString(report, true));
+        return reply;
+    }
+
+    var reports;
+    for (int i = 0; i < message.size(); i++) {
+        const String filePath = message[i].getString();
+        AudioFileCache::Info info;
+        if (files[i] != File()) info = cache.get(files[i]);
+        reports.append(createAudioFileReport(filePath, files[i], info));
     }
+    reply.addInt32(0);
+    reply.addString("Retrieved JSON reports about " + String(message.size()) + " audio files");
+    reply.addString(JSON::toString(reports, true));
+    return reply;
+}
+
+File FluidOscServer::findAudioFile(const String& filePath) const {
+    File file;
+    // The default filePathResolver checks for an absolute file, then looks
+    // in the relative to the edit file directory (using edit.editFileRetriever)
+    if (File::isAbsolutePath(filePath))   file = File(filePath);
+    if (file == File() && activeCybrEdit) file = activeCybrEdit->getEdit().filePathResolver(filePath);
+    if (file == File())                   file = CybrSearchPath(CYBR_SAMPLE).find(filePath);
+    return file;
+}
+
+var FluidOscServer::createAudioFileReport(const String& givenPath, const File& file, const AudioFileCache::Info& info) {
+    DynamicObject::Ptr report = new DynamicObject();
+    report->setProperty("givenPath", givenPath);
+    if (file == File()) {
+        report->setProperty("error", "file not found");
+        return var(report.get());
+    }
+    report->setProperty("absolutePath", file.getFullPathName());
+    if (!info.isValid()) {
+        report->setProperty("error", "failed to read file");
+        return var(report.get());
+    }
+    report->setProperty("format", info.format);
+    report->setProperty("lengthSeconds", info.getLengthSeconds());
+    report->setProperty("lengthSamples", info.lengthSamples);
+    report->setProperty("sampleRate", info.sampleRate);
+    report->setProperty("numChannels", info.numChannels);
+    report->setProperty("bitDepth", info.bitDepth);
+    return var(report.get());
+}
 
-    constructReply(reply, 1, "Cannot get audio file report: unknown error");
+OSCMessage FluidOscServer::getMetricsReport(const OSCMessage& message) {
+    // Args
+    // 0 - (int, optional) if non-zero, reset the metrics after reporting
+    OSCMessage reply("/metrics/report/reply");
+    const bool reset = message.size() && message[0].isInt32() && message[0].getInt32();
+
+    String jsonString = JSON::toString(OscMetrics::getInstance().getReport(), true);
+    if (reset) OscMetrics::getInstance().reset();
+
+    reply.addInt32(0);
+    reply.addString("Retrieved JSON report about OSC request latency");
+    reply.addString(jsonString);
     return reply;
 }
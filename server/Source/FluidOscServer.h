@@ -10,12 +10,50 @@
 
 #pragma once
 #include <iostream>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "cybr_helpers.h"
 #include "CybrEdit.h"
 #include "CybrSearchPath.h"
+#include "StemRenderJob.h"
+#include "RenderCache.h"
+#include "temp_OSCInputStream.h"
+#include "OscMetrics.h"
+#include "RenderStream.h"
+#include "AudioFileCache.h"
 
-typedef void (*OscHandlerFunc)(const juce::OSCMessage&);
+typedef std::function<juce::OSCMessage(const juce::OSCMessage&)> OscHandlerFunc;
+typedef std::function<juce::OSCMessage(const juce::OSCMessageView&)> OscViewHandlerFunc;
+typedef std::function<void(const juce::OSCMessage&)> AsyncReplyFunc;
+typedef std::function<void(const juce::OSCBundle::Element&)> ElementReplyFunc;
+/** Sends a message ahead of a reply. Returns false if it could not be sent. */
+typedef std::function<bool(const juce::OSCMessage&)> StreamReplyFunc;
+
+/** One entry in the FluidOscServer dispatch table */
+struct OscRoute {
+    juce::String address;
+    OscHandlerFunc handler;
+    /** If true, an empty edit is activated before the handler is called */
+    bool needsActiveEdit = true;
+    /** If set, this is called instead of handler, and reads the message's
+     strings and blobs without copying them */
+    OscViewHandlerFunc viewHandler;
+};
+
+/** A packet received over IPC. The views in element point into data. */
+struct OscPacket {
+    juce::MemoryBlock data;
+    juce::OSCElementView element;
+    /** Time taken to decode the packet */
+    juce::int64 decodeMicroseconds = 0;
+
+    /** Copy and decode a packet. Throws juce::OSCFormatError. */
+    static std::shared_ptr<const OscPacket> decode(const juce::MemoryBlock& block);
+};
 
 struct SelectedObjects {
     te::Track* audioTrack = nullptr;
@@ -35,6 +73,54 @@ public:
     
     juce::OSCBundle handleOscBundle(const juce::OSCBundle& bundle, SelectedObjects parentSelection);
     juce::OSCMessage handleOscMessage(const juce::OSCMessage& message);
+    /** Like the methods above, but for decoded views. Handlers registered with
+     addViewMethod receive the views directly. Other handlers receive a copy. */
+    juce::OSCBundle handleOscBundle(const juce::OSCElementView& bundle, SelectedObjects parentSelection);
+    juce::OSCMessage handleOscMessage(const juce::OSCMessageView& message, StreamReplyFunc sendStream = nullptr);
+
+    /** Queue a message or bundle. Queued packets are handled in order on the
+     message thread, and a packet is not started until everything before it
+     has replied, including handlers that used deferReply. sendReply is called
+     exactly once, possibly from another thread. Call from the message thread.
+     If the connection can receive more than one message per request, it may
+     supply sendStream (see getReplyStream). */
+    void enqueue(std::shared_ptr<const OscPacket> packet, ElementReplyFunc sendReply, StreamReplyFunc sendStream = nullptr);
+
+    /** Long running handlers may call this to reply asynchronously. The
+     returned function must be called exactly once with the reply, and the
+     value returned by the handler is discarded. Returns an empty function if
+     the current message cannot be answered asynchronously (for example,
+     inside a bundle), in which case the handler must reply normally. */
+    AsyncReplyFunc deferReply();
+
+    /** Handlers may use the returned function to send messages to the
+     requesting connection before their reply, for example to stream audio as
+     it is rendered. It may be called from any thread, but not after the reply
+     is sent. On the message thread, it may block until the connection has
+     sent earlier messages, but not for longer than the connection's timeout.
+     It returns false if the message could not be sent in time, after which
+     the handler should stop streaming and reply with an error. Returns an
+     empty function if the request came over UDP, over a connection that is
+     not pipelined, or inside a bundle. */
+    StreamReplyFunc getReplyStream() const { return replyStream; }
+
+    /** Get the metrics to record a request against: "#bundle" for bundles,
+     or the address of the route a message matches. Returns nullptr if the
+     message matches no route, so unroutable addresses do not each get an
+     entry. Thread safe. */
+    OscMetrics::Address* getMetrics(const juce::OSCElementView& element) const;
+
+    /** Register a handler for a literal OSC address. Incoming messages are
+     dispatched with a single hash lookup on their address. Messages whose
+     address pattern contains wildcards fall back to matching against every
+     registered address, in registration order. */
+    void addMethod(const juce::String& address, OscHandlerFunc handler, bool needsActiveEdit = true);
+    /** Register a handler for every address beginning with prefix. Prefix
+     methods are only checked when no literal address matched. */
+    void addPrefixMethod(const juce::String& prefix, OscHandlerFunc handler, bool needsActiveEdit = true);
+    /** Register a handler that reads its arguments from an OSCMessageView.
+     Use this for handlers that receive large strings or blobs. */
+    void addViewMethod(const juce::String& address, OscViewHandlerFunc handler, bool needsActiveEdit = true);
 
     // message handlers
     juce::OSCMessage selectAudioTrack(const juce::OSCMessage& message);
@@ -46,6 +132,7 @@ public:
     juce::OSCMessage selectPlugin(const juce::OSCMessage& message);
     juce::OSCMessage setPluginParam(const juce::OSCMessage& message);
     juce::OSCMessage setPluginParamAt(const juce::OSCMessage& message);
+    juce::OSCMessage setPluginParamCurve(const juce::OSCMessageView& message);
     juce::OSCMessage setTrackWidth(const juce::OSCMessage& message);
     juce::OSCMessage setPluginSideChainInput(const juce::OSCMessage& message);
     juce::OSCMessage getPluginReport(const juce::OSCMessage& message);
@@ -53,10 +140,11 @@ public:
     juce::OSCMessage getPluginParametersReport(const juce::OSCMessage& message);
     juce::OSCMessage savePluginPreset(const juce::OSCMessage& message);
     juce::OSCMessage loadPluginPreset(const juce::OSCMessage& message);
-    juce::OSCMessage loadPluginTrkpreset(const juce::OSCMessage& message);
+    juce::OSCMessage loadPluginTrkpreset(const juce::OSCMessageView& message);
     juce::OSCMessage ensureSend(const juce::OSCMessage& message);
     juce::OSCMessage clearMidiClip(const juce::OSCMessage& message);
     juce::OSCMessage insertMidiNote(const juce::OSCMessage& message);
+    juce::OSCMessage insertMidiNotes(const juce::OSCMessageView& message);
     juce::OSCMessage insertWaveSample(const juce::OSCMessage& message);
     juce::OSCMessage saveActiveEdit(const juce::OSCMessage& message);
     juce::OSCMessage activateEditFile(const juce::OSCMessage& message);
@@ -67,6 +155,9 @@ public:
     juce::OSCMessage setTrackPan(const juce::OSCMessage& message);
     juce::OSCMessage renderRegion(const juce::OSCMessage& message);
     juce::OSCMessage renderClip(const juce::OSCMessage& message);
+    juce::OSCMessage renderStems(const juce::OSCMessage& message);
+    juce::OSCMessage streamRegion(const juce::OSCMessage& message);
+    juce::OSCMessage streamClip(const juce::OSCMessage& message);
     juce::OSCMessage setClipLength(const juce::OSCMessage& message);
     juce::OSCMessage trimClipBySeconds(const juce::OSCMessage& message);
     juce::OSCMessage selectClip(const juce::OSCMessage& message);
@@ -76,6 +167,7 @@ public:
     juce::OSCMessage setTempo(const juce::OSCMessage& message);
     juce::OSCMessage clearContent(const juce::OSCMessage& message);
     juce::OSCMessage getAudioFileReport(const juce::OSCMessage& message);
+    juce::OSCMessage getMetricsReport(const juce::OSCMessage& message);
 
     // everything else
     juce::OSCMessage muteTrack(bool mute);
@@ -86,6 +178,57 @@ public:
     SelectedObjects getSelectedObjects();
 
 private:
+    typedef juce::OSCMessage (FluidOscServer::*OscMethod)(const juce::OSCMessage&);
+    typedef juce::OSCMessage (FluidOscServer::*OscViewMethod)(const juce::OSCMessageView&);
+    OscHandlerFunc bind(OscMethod method);
+    OscViewHandlerFunc bind(OscViewMethod method);
+
+    /** Declare every OSC method handled by the server. Called once, by the
+     constructor. */
+    void registerMethods();
+    const OscRoute* findRoute(const juce::String& address) const;
+    /** Activate an empty edit if route needs one and there is no active edit */
+    void prepareRoute(const OscRoute& route);
+    /** Record a handler's latency, and whether it replied with an error,
+     against the address of the handler's route */
+    static void recordHandled(const juce::String& address, double startMs, const juce::OSCMessage& reply);
+
+    struct StringHash {
+        size_t operator()(const juce::String& s) const noexcept { return (size_t) s.hashCode64(); }
+    };
+    std::vector<OscRoute> routes;
+    std::vector<OscRoute> prefixRoutes;
+    std::unordered_map<juce::String, size_t, StringHash> routeIndex;
+
+    struct PendingRequest {
+        std::shared_ptr<const OscPacket> packet;
+        ElementReplyFunc sendReply;
+        StreamReplyFunc sendStream;
+    };
+    void handlePendingRequests();
+    std::deque<PendingRequest> pendingRequests;
+    bool requestInProgress = false;
+    /** How many bundles are being handled. Only top level bundles are recorded
+     in the metrics. */
+    int bundleDepth = 0;
+    AsyncReplyFunc asyncReply;
+    bool replyDeferred = false;
+    StreamReplyFunc replyStream;
+
+    /** Render track over range, streaming the audio to the requesting
+     connection. message[0] is the encoding, and the first int argument (if
+     any) the number of frames per block. */
+    juce::OSCMessage streamTrackRegion(juce::OSCMessage reply,
+                                       te::Track& track,
+                                       te::EditTimeRange range,
+                                       const juce::OSCMessage& message);
+
+    /** Find an audio file by absolute path, relative to the edit, or in the
+     sample search path. Returns File() if the file was not found. */
+    juce::File findAudioFile(const juce::String& filePath) const;
+    static juce::var createAudioFileReport(const juce::String& givenPath,
+                                           const juce::File& file,
+                                           const AudioFileCache::Info& info);
 
     /** Recursively handle all messages and nested bundles, reseting the
      selection state to parentSelection after each bundle. This should ensure
@@ -94,9 +237,26 @@ private:
 
     void constructReply(juce::OSCMessage &reply, int error, juce::String message);
     void constructReply(juce::OSCMessage &reply, juce::String message);
+
+    /** Find a parameter (or rack macro) on the selected plugin by name. Returns
+     an empty Ptr if there is no such parameter. */
+    te::AutomatableParameter::Ptr findSelectedPluginParam(const juce::String& paramName);
+
+    /** Created the first time a plugin is selected */
+    KnownPluginIndex& getKnownPluginIndex();
+    std::unique_ptr<KnownPluginIndex> knownPluginIndex;
     
     te::Track* selectedTrack = nullptr;
     te::Clip* selectedClip = nullptr;
     te::Plugin* selectedPlugin = nullptr;
+
+    RenderCache renderCache;
+
+    /** Writes .tracktionedit files for deferred /file/save replies. Declared
+     after activeCybrEdit, so that jobs are finished before the edit is
+     deleted. */
+    juce::ThreadPool backgroundJobs;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(FluidOscServer)
 };
 
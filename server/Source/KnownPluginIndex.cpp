@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    KnownPluginIndex.cpp
+    Created: 16 Oct 2026 8:42:04pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "KnownPluginIndex.h"
+
+using namespace juce;
+
+KnownPluginIndex::KnownPluginIndex(KnownPluginList& l) : list(l) {
+    list.addChangeListener(this);
+}
+
+KnownPluginIndex::~KnownPluginIndex() {
+    list.removeChangeListener(this);
+}
+
+void KnownPluginIndex::rebuild() {
+    types = list.getTypes();
+    exact.clear();
+    sorted.clear();
+    sorted.reserve(types.size());
+    for (int i = 0; i < types.size(); i++) {
+        String lowerName = types.getReference(i).name.toLowerCase();
+        exact[lowerName].push_back(i);
+        sorted.emplace_back(lowerName, i);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    needsRebuild = false;
+}
+
+bool KnownPluginIndex::matchesType(int i, const String& type) const {
+    return type.isEmpty() || type.equalsIgnoreCase(types.getReference(i).pluginFormatName);
+}
+
+bool KnownPluginIndex::findExact(const String& name, const String& type, PluginDescription& result) {
+    if (needsRebuild) rebuild();
+    auto found = exact.find(name.toLowerCase());
+    if (found == exact.end()) return false;
+    for (int i : found->second) {
+        if (matchesType(i, type)) {
+            result = types.getReference(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KnownPluginIndex::findPrefix(const String& prefix, const String& type, PluginDescription& result) {
+    if (needsRebuild) rebuild();
+    const String lowerPrefix = prefix.toLowerCase();
+
+    // Every name with this prefix sorts into one contiguous run. Pick the
+    // match that comes first in the list's order.
+    int best = -1;
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(lowerPrefix, -1));
+    for (; it != sorted.end() && it->first.startsWith(lowerPrefix); ++it) {
+        if ((best == -1 || it->second < best) && matchesType(it->second, type)) best = it->second;
+    }
+    if (best == -1) return false;
+    result = types.getReference(best);
+    return true;
+}
+
+bool KnownPluginIndex::isInternalType(te::Edit& edit, const String& name) {
+    auto found = internalTypes.find(name);
+    if (found != internalTypes.end()) return found->second;
+    bool isInternal = edit.getPluginCache().createNewPlugin(name, PluginDescription()).get() != nullptr;
+    internalTypes[name] = isInternal;
+    return isInternal;
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    KnownPluginIndex.h
+    Created: 16 Oct 2026 8:42:04pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Case insensitive lookup of scanned plugins by name, used by
+ getOrCreatePluginByName in place of walking KnownPluginList::getTypes().
+
+ The index is rebuilt the first time it is used after the KnownPluginList
+ broadcasts a change. Lookups return the first match in the list's order,
+ like the linear searches did. Message thread only.
+ */
+class KnownPluginIndex : private juce::ChangeListener {
+public:
+    KnownPluginIndex(juce::KnownPluginList& list);
+    ~KnownPluginIndex();
+
+    /** Find a plugin whose name equals name. If type is not empty, only
+     plugins with that format name (ex. "VST3") are considered. */
+    bool findExact(const juce::String& name, const juce::String& type, juce::PluginDescription& result);
+    /** Find a plugin whose name starts with prefix */
+    bool findPrefix(const juce::String& prefix, const juce::String& type, juce::PluginDescription& result);
+
+    /** Returns true if an internal ("tracktion") plugin of this type exists.
+     The first check for each name creates a plugin to find out. The answer is
+     remembered, because internal types do not change while running. */
+    bool isInternalType(te::Edit& edit, const juce::String& name);
+
+private:
+    void changeListenerCallback(juce::ChangeBroadcaster*) override { needsRebuild = true; }
+    void rebuild();
+    bool matchesType(int i, const juce::String& type) const;
+
+    struct StringHash {
+        size_t operator()(const juce::String& s) const noexcept { return (size_t) s.hashCode64(); }
+    };
+
+    juce::KnownPluginList& list;
+    bool needsRebuild = true;
+    juce::Array<juce::PluginDescription> types;
+    /** lowercase name -> indices into types, in list order */
+    std::unordered_map<juce::String, std::vector<int>, StringHash> exact;
+    /** (lowercase name, index into types), sorted by name then index */
+    std::vector<std::pair<juce::String, int>> sorted;
+    std::unordered_map<juce::String, bool, StringHash> internalTypes;
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    LockFreeQueue.h
+    Created: 16 Oct 2026 9:09:49pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <vector>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/** A fixed-capacity, single producer, single consumer queue that passes
+ objects between threads without locking or allocating.
+
+ T is copied in and out of preallocated storage, so it should be trivially
+ copyable, and should not own memory (see TimestampedOscMessage). When the
+ queue is full, new items are dropped and counted. Several producers may
+ share a queue only if they never write at the same time.
+ */
+template <typename T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(int capacity)
+    : fifo(capacity + 1), storage((size_t)(capacity + 1)) {}
+
+    int getCapacity() const { return fifo.getTotalSize() - 1; }
+    int getNumReady() const { return fifo.getNumReady(); }
+
+    /** Write one item. Returns false (and counts a drop) if the queue is full.
+     Call from the producer thread. */
+    bool write(const T& item) { return write(&item, 1) == 1; }
+
+    /** Write as many items as will fit, and return how many were written.
+     The rest are counted as dropped. Call from the producer thread. */
+    int write(const T* items, int numItems) {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numItems, start1, size1, start2, size2);
+        for (int i = 0; i < size1; i++) storage[(size_t)(start1 + i)] = items[i];
+        for (int i = 0; i < size2; i++) storage[(size_t)(start2 + i)] = items[size1 + i];
+        fifo.finishedWrite(size1 + size2);
+
+        const int numWritten = size1 + size2;
+        if (numWritten < numItems) dropped += numItems - numWritten;
+        const int numReady = fifo.getNumReady();
+        if (numReady > highWaterMark.load(std::memory_order_relaxed)) highWaterMark = numReady;
+        return numWritten;
+    }
+
+    /** Call after writing. Returns true if this is the first write since the
+     last read, meaning the consumer should be woken up. A consumer that is
+     woken this way never misses an item, and is woken at most once per read. */
+    bool shouldWakeReader() { return needsWakeUp.exchange(false); }
+
+    /** Replace the contents of received with every waiting item, and return
+     how many there were. If received has a capacity of at least
+     getCapacity(), this never allocates. Call from the consumer thread. */
+    int read(std::vector<T>& received) {
+        received.clear();
+        // Reset before reading, so an item written during the read wakes the
+        // reader again.
+        needsWakeUp = true;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+        received.insert(received.end(), storage.begin() + start1, storage.begin() + start1 + size1);
+        received.insert(received.end(), storage.begin() + start2, storage.begin() + start2 + size2);
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    /** Items dropped because the queue was full */
+    juce::int64 getNumDropped() const { return dropped.load(); }
+    /** The most items that have been waiting at once */
+    int getHighWaterMark() const { return highWaterMark.load(); }
+    void resetCounters() {
+        dropped = 0;
+        highWaterMark = 0;
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<T> storage;
+    std::atomic<bool> needsWakeUp { true };
+    std::atomic<juce::int64> dropped { 0 };
+    std::atomic<int> highWaterMark { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(LockFreeQueue)
+};
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    MixdownRenderJob.cpp
+    Created: 16 Oct 2026 8:56:29pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "MixdownRenderJob.h"
+#include "CybrLog.h"
+
+using namespace juce;
+
+MixdownRenderJob::MixdownRenderJob(te::Edit& edit,
+                                   const File& outputFile,
+                                   te::EditTimeRange range,
+                                   int blockSize)
+: edit(edit), outputFile(outputFile), range(range) {
+    auto& dm = edit.engine.getDeviceManager();
+    this->blockSize = blockSize > 0 ? blockSize : dm.getBlockSize();
+    sampleRate = dm.getSampleRate();
+}
+
+bool MixdownRenderJob::render() {
+    JUCE_ASSERT_MESSAGE_THREAD
+    const double startMs = Time::getMillisecondCounterHiRes();
+    numThreads = edit.engine.getEngineBehaviour().getNumberOfCPUsToUseForAudio();
+    if (outputFile.exists() && !outputFile.deleteFile()) {
+        CYBR_LOG(error, render, "Cannot render mixdown: Failed to delete existing file: " << outputFile.getFullPathName());
+        return success = false;
+    }
+
+    // Just add all the tracks to the bitmask
+    BigInteger tracksToDo;
+    tracksToDo.setRange(0, te::getAllTracks(edit).size(), true);
+
+    // The same settings te::Renderer::renderToFile uses, except blockSize
+    te::Renderer::Parameters params(edit);
+    params.destFile = outputFile;
+    params.audioFormat = edit.engine.getAudioFileFormatManager().getWavFormat();
+    params.bitDepth = 24;
+    params.blockSizeForAudio = blockSize;
+    params.sampleRateForAudio = sampleRate;
+    params.time = range;
+    params.tracksToDo = tracksToDo;
+    params.usePlugins = true;
+    params.useMasterPlugins = true;
+    params.createMidiFile = false;
+    success = te::Renderer::renderToFile("Chaz Render Job", params).existsAsFile();
+    wallSeconds = (Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+
+    if (success) {
+        CYBR_LOG(info, render, "Rendered " << outputFile.getFullPathName() << ": "
+            << range.getLength() << " seconds of audio in " << wallSeconds << " seconds ("
+            << getRealtimeFactor() << "x realtime) with " << blockSize << " sample blocks on "
+            << numThreads << " threads");
+    } else {
+        CYBR_LOG(error, render, "Failed to render: " << outputFile.getFullPathName());
+    }
+    return success;
+}
+
+double MixdownRenderJob::getRealtimeFactor() const {
+    return wallSeconds > 0 ? range.getLength() / wallSeconds : 0;
+}
+
+var MixdownRenderJob::getReport() const {
+    DynamicObject::Ptr report = new DynamicObject();
+    report->setProperty("file", outputFile.getFullPathName());
+    report->setProperty("success", success);
+    report->setProperty("blockSize", blockSize);
+    report->setProperty("threads", numThreads);
+    report->setProperty("audioSeconds", range.getLength());
+    report->setProperty("wallSeconds", wallSeconds);
+    report->setProperty("realtimeFactor", getRealtimeFactor());
+    return var(report.get());
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    MixdownRenderJob.h
+    Created: 16 Oct 2026 8:56:29pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Render the mix of an edit to a .wav file, and measure how long it took.
+
+ te::Renderer must run on the message thread, so the whole edit is rendered
+ there in one pass. Within that pass, the engine mixes independent tracks on
+ EngineBehaviour::getNumberOfCPUsToUseForAudio threads. Offline renders do not
+ need the device's small block size, and a larger block reduces per-block
+ overhead. Every method must be called on the message thread.
+ */
+class MixdownRenderJob {
+public:
+    /** If blockSize is 0, use the audio device's block size */
+    MixdownRenderJob(te::Edit& edit,
+                     const juce::File& outputFile,
+                     te::EditTimeRange range,
+                     int blockSize = 0);
+
+    /** Render, blocking until finished. Returns true on success. */
+    bool render();
+
+    int getBlockSize() const { return blockSize; }
+    int getNumThreads() const { return numThreads; }
+    double getWallSeconds() const { return wallSeconds; }
+    /** Seconds of audio rendered per second of wall time */
+    double getRealtimeFactor() const;
+
+    /** Get a JSON friendly summary of the most recent render */
+    juce::var getReport() const;
+
+private:
+    te::Edit& edit;
+    juce::File outputFile;
+    te::EditTimeRange range;
+    int blockSize;
+    int numThreads = 1;
+    double sampleRate;
+    bool success = false;
+    double wallSeconds = 0;
+};
@@ -9,6 +9,7 @@
 */
 
 #include "OpenFrameworksPlugin.h"
+#include "CybrLog.h"
 
 using namespace juce;
 
@@ -51,14 +52,12 @@ void OpenFrameworksPlugin::applyToBuffer(const te::PluginRenderContext& fc)
     if (fc.bufferForMidiMessages != nullptr) {
         fc.bufferForMidiMessages->addToNoteNumbers(roundToInt(semitones->getCurrentValue()));
         for (auto& msg : *(fc.bufferForMidiMessages)) {
-            std::cout
-                << "Got midi message: "
+            CYBR_LOG(debug, audio, "Got midi message: "
                 << fc.editTime
                 << " juce::Time seconds: " << Time::getMillisecondCounterHiRes() * 0.001
                 << msg.getTimeStamp() // This is not really meaningful. It's the time stamp within the block, which I believe is arbitrary. We should really figure out how to playhead->getEditTime (or whatever it is) this value
                 << " - "
-                << msg.getDescription()
-                << std::endl;
+                << msg.getDescription());
         }
     }
 }
@@ -9,6 +9,7 @@
 */
 
 #include "OscInputDevice.h"
+#include "CybrLog.h"
 
 using namespace juce;
 
@@ -66,12 +67,14 @@ OscInputDevice::OscInputDevice(te::Engine& e, const String& name, int listenPort
     // correct, but could also lead to some subtle bugs down the line.
     VirtualMidiInputDevice(e, name, te::InputDevice::virtualMidiDevice)
 {
-    std::cout << "Creating OscInputDevice" << std::endl;
+    CYBR_LOG(info, osc, "Creating OscInputDevice");
     oscReceiver.addListener(this);
+    received.reserve(queueCapacity);
+    bundleMessages.reserve(queueCapacity);
     if (oscReceiver.connect(listenPort)) {
-        std::cout << "Listening for OSC" << std::endl;
+        CYBR_LOG(info, osc, "Listening for OSC");
     } else {
-        std::cout << "Failed to Listen for OSC" << std::endl;
+        CYBR_LOG(error, osc, "Failed to Listen for OSC");
     }
 }
 
@@ -80,7 +83,7 @@ void OscInputDevice::masterTimeUpdate (double streamTime)
     adjustSecs = streamTime - Time::getMillisecondCounterHiRes() * 0.001;
     atomicAdjustSecs.store(adjustSecs, std::memory_order_relaxed); // Charles: I'm not sure if this is the correct memory order
 
-    auto received = incomingMessages.read();
+    incomingMessages.read(received);
     for (auto&& msg : received) {
         msg.streamTime = msg.arrivedAt + adjustSecs;
     }
@@ -112,11 +115,27 @@ void OscInputDevice::removeInstance (OscInputDeviceInstance* i)
 void OscInputDevice::oscMessageReceived(const OSCMessage& message)
 {
     double timeMs = Time::getMillisecondCounterHiRes();
-    incomingMessages.writeMessage(message, timeMs);
+    TimestampedOscMessage timestamped;
+    // Messages that do not fit in a TimestampedOscMessage are ignored
+    if (timestamped.set(message, timeMs)) incomingMessages.write(timestamped);
 }
 
 void OscInputDevice::oscBundleReceived(const OSCBundle& bundle)
 {
-    std::cout << "OSC bundle received" << std::endl;
+    bundleMessages.clear();
+    collectBundleMessages(bundle, Time::getMillisecondCounterHiRes());
+    incomingMessages.write(bundleMessages.data(), (int)bundleMessages.size());
+}
+
+void OscInputDevice::collectBundleMessages(const OSCBundle& bundle, double timeMs)
+{
+    for (const auto& element : bundle) {
+        if (element.isBundle()) {
+            collectBundleMessages(element.getBundle(), timeMs);
+        } else if (bundleMessages.size() < bundleMessages.capacity()) {
+            TimestampedOscMessage timestamped;
+            if (timestamped.set(element.getMessage(), timeMs)) bundleMessages.push_back(timestamped);
+        }
+    }
 }
 
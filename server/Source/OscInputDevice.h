@@ -12,7 +12,8 @@
 #include <iostream>
 #include <vector>
 #include "../JuceLibraryCode/JuceHeader.h"
-#include "TimestampedTest.h"
+#include "LockFreeQueue.h"
+#include "TimestampedOscMessage.h"
 #include "OscInputDeviceInstance.h"
 
 
@@ -41,6 +42,12 @@ public:
     
     void addInstance(OscInputDeviceInstance* i);
     void removeInstance(OscInputDeviceInstance* i);
+    /** Held while the instances handle messages on the "Built-in Output" thread */
+    const juce::CriticalSection& getInstanceLock() const { return instanceLock; }
+
+    /** Capacity of the queues between the network, audio and message threads */
+    static constexpr int queueCapacity = 1024;
+    const LockFreeQueue<TimestampedOscMessage>& getIncomingMessages() const { return incomingMessages; }
     
 protected:
     juce::CriticalSection instanceLock;
@@ -49,6 +56,8 @@ protected:
 private:
     void oscMessageReceived(const juce::OSCMessage& message) override;
     void oscBundleReceived(const juce::OSCBundle& bundle) override;
+    /** Append the messages in bundle (and any bundles nested in it) to bundleMessages */
+    void collectBundleMessages(const juce::OSCBundle& bundle, double timeMs);
     
     juce::OSCReceiver oscReceiver;
     
@@ -56,7 +65,13 @@ private:
      - write to this from the network thread in the OSCReceiver callback
      - read on the Built-in Output thread in the masterTimeUpdate callback
      */
-    LockFreeOscMessageQueue incomingMessages;
+    LockFreeQueue<TimestampedOscMessage> incomingMessages { queueCapacity };
+    /** Messages read from incomingMessages. Preallocated, so reading does not
+     allocate on the audio thread. */
+    std::vector<TimestampedOscMessage> received;
+    /** The messages in a bundle, so they can be written in one batch. Only
+     used on the network thread. */
+    std::vector<TimestampedOscMessage> bundleMessages;
 };
 
 juce::Result createOscInputDevice(te::Engine& engine, const juce::String& name, int listenPort);
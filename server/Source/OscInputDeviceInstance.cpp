@@ -13,7 +13,8 @@
 OscInputDeviceInstance::OscInputDeviceInstance(OscInputDevice& d, te::EditPlaybackContext& c) :
     te::InputDeviceInstance(d, c),
     recordingStartTime(0),
-    recording(false)
+    recording(false),
+    toMessageThread(OscInputDevice::queueCapacity)
 {
     getOscInput().addInstance(this);
 }
@@ -78,13 +79,25 @@ te::Clip::Array OscInputDeviceInstance::applyLastRecordingToEdit (
 }
 
 // Should be called from the OscInputDevice
-void OscInputDeviceInstance::handleOscMessages(std::vector<TimestampedTest> ttMsgs)
+void OscInputDeviceInstance::handleOscMessages(const std::vector<TimestampedOscMessage>& messages)
 {
-    for (auto tt : ttMsgs)
+    if (!recording) return;
+    for (auto message : messages)
     {
-        tt.editTime = context.playhead.streamTimeToSourceTime(tt.streamTime);
-        if (recording && tt.editTime >= recordingStartTime) toMessageThread.writeMessage(tt);
+        message.editTime = context.playhead.streamTimeToSourceTime(message.streamTime);
+        if (message.editTime >= recordingStartTime) toMessageThread.write(message);
     }
+    if (toMessageThread.getNumReady() > 0 && toMessageThread.shouldWakeReader()) {
+        if (auto* listener = messageListener.load()) listener->triggerAsyncUpdate();
+    }
+}
+
+void OscInputDeviceInstance::setMessageListener(juce::AsyncUpdater* listener)
+{
+    if (messageListener == listener) return;
+    // handleOscMessages is only called with the device's instance lock held
+    const juce::ScopedLock sl (getOscInput().getInstanceLock());
+    messageListener = listener;
 }
 
 void OscInputDeviceInstance::addConsumer (te::InputDeviceInstance::Consumer* node) { juce::ScopedLock sl (nodeLock); nodes.addIfNotAlreadyThere (node); }
@@ -11,7 +11,8 @@
 #pragma once
 #include <vector>
 #include "../JuceLibraryCode/JuceHeader.h"
-#include "TimestampedTest.h"
+#include "LockFreeQueue.h"
+#include "TimestampedOscMessage.h"
 #include "OscInputDevice.h"
 
 
@@ -60,7 +61,13 @@ public:
 
     /** Process all the incoming OSC messages. Like `masterTimeUpdate` this is called by
      OscInputDevice on the "Built-in Output" thread. */
-    void handleOscMessages(std::vector<TimestampedTest> ttMsgs);
+    void handleOscMessages(const std::vector<TimestampedOscMessage>& messages);
+
+    /** Set the object to notify (on the message thread) when messages arrive
+     in toMessageThread. It is triggered once per read of the queue, rather
+     than once per message. Call from the message thread. Once this returns,
+     the previous listener will not be triggered again, so it may be deleted. */
+    void setMessageListener(juce::AsyncUpdater* listener);
     
     /** Called automatically, apparently on every block during recording */
     te::Clip::Array applyLastRecordingToEdit (te::EditTimeRange recordedRange,
@@ -84,16 +91,14 @@ public:
     /** Are we currently recording? */
     std::atomic<bool> recording;
     
-    /** Pass messages from edit to the message thread.
-     It's a little bit risky to make this public, because we don't want anyone
-     replacing it. It will be refactored when we template it, so for now just
-     using a public member is a reasonable compromize. */
-    LockFreeOscMessageQueue toMessageThread;
+    /** Pass messages from edit to the message thread. */
+    LockFreeQueue<TimestampedOscMessage> toMessageThread;
 
     void addConsumer (Consumer* node) override;
     void removeConsumer (Consumer* node) override;
 
 private:
+    std::atomic<juce::AsyncUpdater*> messageListener { nullptr };
     juce::CriticalSection nodeLock;
     juce::Array<te::InputDeviceInstance::Consumer*> nodes;
 };
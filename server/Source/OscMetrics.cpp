@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    OscMetrics.cpp
+    Created: 16 Oct 2026 8:54:32pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "OscMetrics.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace juce;
+
+//==============================================================================
+int LatencyHistogram::getCountsIndex(int64 value) {
+    value = jlimit((int64)0, ((int64)1 << maxValueBits) - 1, value);
+    // Values below 2 * subBucketHalfCount are counted exactly. Above that,
+    // each power of two range gets subBucketHalfCount buckets.
+    int bucket = 0;
+    while ((value >> bucket) >= subBucketHalfCount * 2) bucket++;
+    return bucket * subBucketHalfCount + (int)(value >> bucket);
+}
+
+int64 LatencyHistogram::getHighestValueAt(int index) {
+    const int bucket = index < subBucketHalfCount * 2 ? 0 : index / subBucketHalfCount - 1;
+    const int64 subBucket = index - bucket * subBucketHalfCount;
+    return ((subBucket + 1) << bucket) - 1;
+}
+
+void LatencyHistogram::record(int64 microseconds) {
+    microseconds = jmax((int64)0, microseconds);
+    counts[getCountsIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(microseconds, std::memory_order_relaxed);
+    int64 previous = max.load(std::memory_order_relaxed);
+    while (microseconds > previous && !max.compare_exchange_weak(previous, microseconds)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : counts) c.store(0);
+    count.store(0);
+    total.store(0);
+    max.store(0);
+}
+
+int64 LatencyHistogram::getPercentile(double fraction) const {
+    // Counts may change while we read them, so stop at the last bucket
+    // instead of trusting count.
+    const int64 target = jmax((int64)1, (int64)std::ceil(jlimit(0.0, 1.0, fraction) * (double)getCount()));
+    int64 seen = 0;
+    for (int i = 0; i < numCounts; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) return jmin(getHighestValueAt(i), max.load());
+    }
+    return max.load();
+}
+
+var LatencyHistogram::toVar() const {
+    const int64 n = getCount();
+    DynamicObject::Ptr object = new DynamicObject();
+    object->setProperty("count", n);
+    object->setProperty("totalMs", getTotal() / 1000.0);
+    object->setProperty("meanMs", n ? getTotal() / 1000.0 / n : 0.0);
+    object->setProperty("p50Ms", n ? getPercentile(0.5) / 1000.0 : 0.0);
+    object->setProperty("p90Ms", n ? getPercentile(0.9) / 1000.0 : 0.0);
+    object->setProperty("p99Ms", n ? getPercentile(0.99) / 1000.0 : 0.0);
+    object->setProperty("maxMs", max.load() / 1000.0);
+    return var(object.get());
+}
+
+//==============================================================================
+OscMetrics& OscMetrics::getInstance() {
+    static OscMetrics metrics;
+    return metrics;
+}
+
+OscMetrics::Address& OscMetrics::get(const String& address) {
+    const ScopedLock sl(lock);
+    auto& entry = addresses[address];
+    if (!entry) entry = std::make_unique<Address>();
+    return *entry;
+}
+
+int64 OscMetrics::elapsedMicroseconds(double startMs) {
+    return (int64)((Time::getMillisecondCounterHiRes() - startMs) * 1000.0);
+}
+
+var OscMetrics::getReport() const {
+    std::vector<std::pair<int64, var>> entries;
+    {
+        const ScopedLock sl(lock);
+        for (const auto& it : addresses) {
+            const Address& metrics = *it.second;
+            DynamicObject::Ptr object = new DynamicObject();
+            object->setProperty("address", it.first);
+            object->setProperty("count", metrics.handle.getCount());
+            object->setProperty("errors", metrics.errors.load());
+            object->setProperty("decode", metrics.decode.toVar());
+            object->setProperty("handle", metrics.handle.toVar());
+            object->setProperty("encode", metrics.encode.toVar());
+            entries.push_back({ metrics.handle.getTotal(), var(object.get()) });
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const std::pair<int64, var>& a, const std::pair<int64, var>& b) {
+        return a.first > b.first;
+    });
+
+    Array<var> addressReports;
+    for (const auto& entry : entries) addressReports.add(entry.second);
+    DynamicObject::Ptr report = new DynamicObject();
+    report->setProperty("addresses", addressReports);
+    return var(report.get());
+}
+
+void OscMetrics::reset() {
+    const ScopedLock sl(lock);
+    for (auto& it : addresses) {
+        it.second->errors.store(0);
+        it.second->decode.reset();
+        it.second->handle.reset();
+        it.second->encode.reset();
+    }
+}
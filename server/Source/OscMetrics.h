@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    OscMetrics.h
+    Created: 16 Oct 2026 8:54:32pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <map>
+#include <memory>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/** A latency histogram in the style of HdrHistogram. Values are recorded in
+ microseconds. Each power of two range is split into 16 linear buckets, so
+ percentiles are accurate to about 6%, from 1 microsecond up to several hours.
+ Recording is lock-free, and may happen on any thread. */
+class LatencyHistogram {
+public:
+    void record(juce::int64 microseconds);
+    void reset();
+
+    juce::int64 getCount() const { return count.load(); }
+    juce::int64 getTotal() const { return total.load(); }
+    /** The smallest recorded value that is greater than or equal to the
+     given fraction (0 to 1) of all values, rounded up to its bucket */
+    juce::int64 getPercentile(double fraction) const;
+
+    /** count, totalMs, meanMs, p50Ms, p90Ms, p99Ms and maxMs */
+    juce::var toVar() const;
+
+private:
+    static constexpr int subBucketBits = 5;
+    static constexpr int subBucketHalfCount = 1 << (subBucketBits - 1);
+    static constexpr int maxValueBits = 36;
+    static constexpr int numCounts = (maxValueBits - subBucketBits + 2) * subBucketHalfCount;
+
+    static int getCountsIndex(juce::int64 value);
+    static juce::int64 getHighestValueAt(int index);
+
+    std::atomic<juce::uint32> counts[numCounts] {};
+    std::atomic<juce::int64> count { 0 };
+    std::atomic<juce::int64> total { 0 };
+    std::atomic<juce::int64> max { 0 };
+};
+
+/** Per-address counters and latency histograms for OSC requests.
+
+ Times are recorded against the address of the route that handled the
+ request, so messages that match no route are not recorded, and wildcard or
+ prefix addresses share their route's entry. Top level bundles are recorded
+ against "#bundle" (nested bundles are part of their parent's time), and each
+ message in a bundle is recorded against its own route (except for decoding,
+ which happens once for the whole bundle).
+ */
+class OscMetrics {
+public:
+    struct Address {
+        std::atomic<juce::int64> errors { 0 };
+        /** Time to decode the request packet */
+        LatencyHistogram decode;
+        /** Time from dispatch to the reply, including deferred replies */
+        LatencyHistogram handle;
+        /** Time to encode the reply */
+        LatencyHistogram encode;
+    };
+
+    /** The metrics shared by every FluidOscServer and IPC connection */
+    static OscMetrics& getInstance();
+
+    /** Get the metrics for an address, creating them if needed. The returned
+     reference is valid for the lifetime of the OscMetrics. Thread safe. */
+    Address& get(const juce::String& address);
+
+    /** Microseconds since startMs (from Time::getMillisecondCounterHiRes) */
+    static juce::int64 elapsedMicroseconds(double startMs);
+
+    /** A JSON friendly report, with one object per address, sorted by total
+     handle time (slowest first) */
+    juce::var getReport() const;
+    void reset();
+
+private:
+    juce::CriticalSection lock;
+    std::map<juce::String, std::unique_ptr<Address>> addresses;
+};
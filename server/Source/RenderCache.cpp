@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    RenderCache.cpp
+    Created: 16 Oct 2026 8:37:52pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "RenderCache.h"
+#include "CybrLog.h"
+
+using namespace juce;
+
+namespace {
+    /** Append the path, size and modification time of every source file that
+     the tree (or any of its descendants) refers to. */
+    void appendSourceFiles(te::Edit& edit, const ValueTree& tree, MemoryOutputStream& out) {
+        if (tree.hasProperty(te::IDs::source)) {
+            File file = edit.filePathResolver(tree[te::IDs::source].toString());
+            if (file.existsAsFile()) {
+                out << file.getFullPathName() << ":"
+                    << file.getSize() << ":"
+                    << file.getLastModificationTime().toMilliseconds() << "\n";
+            }
+        }
+        for (const auto& child : tree) appendSourceFiles(edit, child, out);
+    }
+
+    /** A copy of a track's state without its nested tracks */
+    ValueTree getOwnState(const ValueTree& trackState) {
+        ValueTree copy = trackState.createCopy();
+        for (int i = copy.getNumChildren(); --i >= 0;)
+            if (te::TrackList::isTrack(copy.getChild(i))) copy.removeChild(i, nullptr);
+        return copy;
+    }
+
+    /** Returns the aux bus a send or return plugin uses, or -1 */
+    int getAuxBus(te::Plugin& plugin, bool& isSend) {
+        isSend = false;
+        if (auto send = dynamic_cast<te::AuxSendPlugin*>(&plugin)) {
+            isSend = true;
+            return send->busNumber;
+        }
+        if (auto auxReturn = dynamic_cast<te::AuxReturnPlugin*>(&plugin)) return auxReturn->busNumber;
+        return -1;
+    }
+
+    /** A track whose state feeds a render. Parents of those tracks only
+     contribute their own plugins, not their other children. */
+    struct KeyTrack {
+        te::Track* track;
+        bool wholeSubtree;
+    };
+
+    void addKeyTrack(std::vector<KeyTrack>& keyTracks, te::Track* track, bool wholeSubtree) {
+        for (const auto& keyTrack : keyTracks)
+            if (keyTrack.track == track && (keyTrack.wholeSubtree || !wholeSubtree)) return;
+        keyTracks.push_back({ track, wholeSubtree });
+    }
+}
+
+String RenderCache::createKey(te::Track& track, te::EditTimeRange range) {
+    te::Edit& edit = track.edit;
+    const auto allTracks = te::getAllTracks(edit);
+
+    // Find every track that can change the render: the rendered track and its
+    // parents, and any track connected to those through an aux bus or a
+    // sidechain (and their parents, and so on). External plugins only copy
+    // their state into the ValueTree when asked, so flush the plugins of
+    // these tracks (and only these) along the way.
+    std::vector<KeyTrack> keyTracks { { &track, true } };
+    for (size_t i = 0; i < keyTracks.size(); i++) {
+        const KeyTrack keyTrack = keyTracks[i];
+        for (auto parent = keyTrack.track->getParentTrack(); parent; parent = parent->getParentTrack())
+            addKeyTrack(keyTracks, parent, false);
+
+        for (auto checkTrack : allTracks) {
+            const bool inKeyTrack = checkTrack == keyTrack.track
+                || (keyTrack.wholeSubtree && checkTrack->isAChildOf(*keyTrack.track));
+            if (!inKeyTrack) continue;
+            for (auto plugin : checkTrack->pluginList) {
+                plugin->flushPluginStateToValueTree();
+                if (auto source = te::findTrackForID(edit, plugin->getSidechainSourceID()))
+                    addKeyTrack(keyTracks, source, true);
+                bool isSend;
+                const int bus = getAuxBus(*plugin, isSend);
+                if (bus < 0) continue;
+                // A send feeds the matching returns, and a return is fed by
+                // the matching sends
+                for (auto otherTrack : allTracks) {
+                    for (auto otherPlugin : otherTrack->pluginList) {
+                        bool otherIsSend;
+                        if (getAuxBus(*otherPlugin, otherIsSend) == bus && otherIsSend != isSend)
+                            addKeyTrack(keyTracks, otherTrack, true);
+                    }
+                }
+            }
+        }
+    }
+    for (auto plugin : edit.getMasterPluginList()) plugin->flushPluginStateToValueTree();
+    for (auto rackType : edit.getRackList().getTypes())
+        for (auto plugin : rackType->getPlugins()) plugin->flushPluginStateToValueTree();
+
+    MemoryOutputStream out;
+    for (const auto& keyTrack : keyTracks) {
+        ValueTree state = keyTrack.wholeSubtree ? keyTrack.track->state : getOwnState(keyTrack.track->state);
+        out << state.toXmlString();
+        appendSourceFiles(edit, state, out);
+    }
+    out << edit.state.getChildWithName(te::IDs::TEMPOSEQUENCE).toXmlString();
+    out << edit.state.getChildWithName(te::IDs::RACKS).toXmlString();
+    out << edit.state.getChildWithName(te::IDs::MASTERPLUGINS).toXmlString();
+    out << String(range.start, 9) << "-" << String(range.end, 9);
+
+    return SHA256(out.getData(), out.getDataSize()).toHexString();
+}
+
+bool RenderCache::isUnchanged(const File& file, const Entry& entry) {
+    return file.existsAsFile()
+        && file.getSize() == entry.size
+        && file.getLastModificationTime().toMilliseconds() == entry.modified;
+}
+
+bool RenderCache::reuse(const String& key, const File& outputFile) {
+    const ScopedLock sl(lock);
+    auto found = entries.find(outputFile.getFullPathName());
+    if (found != entries.end() && found->second.key == key && isUnchanged(outputFile, found->second)) {
+        CYBR_LOG(info, render, "Render cache: reusing " << outputFile.getFullPathName());
+        return true;
+    }
+
+    // The same render may have been written to a different file
+    for (const auto& entry : entries) {
+        File cachedFile(entry.first);
+        if (entry.second.key != key || cachedFile == outputFile) continue;
+        if (!isUnchanged(cachedFile, entry.second)) continue;
+        if (cachedFile.copyFileTo(outputFile)) {
+            CYBR_LOG(info, render, "Render cache: copied " << cachedFile.getFullPathName()
+                << " to " << outputFile.getFullPathName());
+            Entry copied;
+            copied.key = key;
+            copied.size = outputFile.getSize();
+            copied.modified = outputFile.getLastModificationTime().toMilliseconds();
+            entries[outputFile.getFullPathName()] = copied;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RenderCache::add(const String& key, const File& outputFile) {
+    Entry entry;
+    entry.key = key;
+    entry.size = outputFile.getSize();
+    entry.modified = outputFile.getLastModificationTime().toMilliseconds();
+    const ScopedLock sl(lock);
+    entries[outputFile.getFullPathName()] = entry;
+}
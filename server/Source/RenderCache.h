@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    RenderCache.h
+    Created: 16 Oct 2026 8:37:52pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <map>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Remembers which inputs produced each rendered file, so that a render with
+ unchanged inputs can reuse an existing file instead of rendering again.
+
+ A key covers the track's ValueTree (including plugin state), the plugins of
+ its parent tracks, any track connected to those by an aux bus or a sidechain,
+ the edit's tempo sequence, racks and master plugins, the modification times of
+ every source file those tracks refer to, and the time range. Create keys on
+ the message thread. The other methods are thread safe.
+ */
+class RenderCache {
+public:
+    /** Create a key for rendering track over range */
+    static juce::String createKey(te::Track& track, te::EditTimeRange range);
+
+    /** If a file rendered with this key still exists and has not been modified
+     since it was rendered, make sure outputFile contains it (copying it if it
+     was rendered to a different file). Returns true if no render is needed. */
+    bool reuse(const juce::String& key, const juce::File& outputFile);
+
+    /** Record that outputFile was just rendered with key */
+    void add(const juce::String& key, const juce::File& outputFile);
+
+private:
+    struct Entry {
+        juce::String key;
+        juce::int64 modified = 0;
+        juce::int64 size = 0;
+    };
+
+    /** Returns true if the file is unchanged since entry was recorded */
+    static bool isUnchanged(const juce::File& file, const Entry& entry);
+
+    juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries; // full path name -> entry
+};
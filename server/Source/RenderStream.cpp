@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    RenderStream.cpp
+    Created: 16 Oct 2026 9:00:12pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "RenderStream.h"
+#include "CybrLog.h"
+#include <cstring>
+
+using namespace juce;
+
+namespace {
+    typedef std::function<bool(const OSCMessage&)> SendFunc;
+
+    /** Sends the samples te::Renderer writes as OSC messages. The output
+     stream is owned (and deleted) by the base class, but never written. */
+    class StreamWriter : public AudioFormatWriter {
+    public:
+        StreamWriter(OutputStream* out,
+                     double sampleRate,
+                     unsigned int numChannels,
+                     RenderStream::Encoding encoding,
+                     int framesPerBlock,
+                     SendFunc& send,
+                     int64& framesSent,
+                     bool& sendFailed)
+        : AudioFormatWriter(out, "cybr stream", sampleRate, numChannels, 32),
+        encoding(encoding),
+        framesPerBlock(framesPerBlock),
+        bytesPerFrame(RenderStream::getBytesPerSample(encoding) * (int)numChannels),
+        send(send),
+        framesSent(framesSent),
+        sendFailed(sendFailed) {
+            // Ask for float samples, and convert them here
+            usesFloatingPointData = true;
+            pending.ensureSize((size_t)(framesPerBlock * bytesPerFrame));
+
+            OSCMessage begin("/render/stream/begin");
+            begin.addInt32((int32)sampleRate);
+            begin.addInt32((int32)numChannels);
+            begin.addString(RenderStream::getEncodingName(encoding));
+            if (!send(begin)) sendFailed = true;
+        }
+
+        ~StreamWriter() override { flush(); }
+
+        bool write(const int** samplesToWrite, int numSamples) override {
+            // Once a message could not be sent, the receiver would only get
+            // part of the audio, so stop the render
+            if (sendFailed) return false;
+            const float** channels = reinterpret_cast<const float**>(samplesToWrite);
+            for (int i = 0; i < numSamples; i++) {
+                char* frame = static_cast<char*>(pending.getData()) + pendingFrames * bytesPerFrame;
+                for (unsigned int ch = 0; ch < numChannels; ch++) {
+                    const float sample = channels[ch] ? channels[ch][i] : 0.0f;
+                    frame = writeSample(frame, sample);
+                }
+                if (++pendingFrames == framesPerBlock) sendBlock();
+            }
+            return true;
+        }
+
+        bool flush() override {
+            if (pendingFrames) sendBlock();
+            return true;
+        }
+
+    private:
+        char* writeSample(char* dest, float sample) {
+            switch (encoding) {
+                case RenderStream::float32: {
+                    uint32 bits;
+                    std::memcpy(&bits, &sample, sizeof(bits));
+                    bits = ByteOrder::swapIfBigEndian(bits);
+                    std::memcpy(dest, &bits, sizeof(bits));
+                    return dest + 4;
+                }
+                case RenderStream::int16: {
+                    const int value = roundToInt(jlimit(-1.0f, 1.0f, sample) * 32767.0f);
+                    dest[0] = (char)(value & 0xff);
+                    dest[1] = (char)((value >> 8) & 0xff);
+                    return dest + 2;
+                }
+                case RenderStream::int24: {
+                    const int value = roundToInt(jlimit(-1.0f, 1.0f, sample) * 8388607.0f);
+                    ByteOrder::littleEndian24BitToChars(value, dest);
+                    return dest + 3;
+                }
+            }
+            return dest;
+        }
+
+        void sendBlock() {
+            OSCMessage block("/render/stream/block");
+            block.addInt32((int32)framesSent);
+            block.addBlob(MemoryBlock(pending.getData(), (size_t)(pendingFrames * bytesPerFrame)));
+            const int numFrames = pendingFrames;
+            pendingFrames = 0;
+            if (sendFailed || !send(block)) {
+                sendFailed = true;
+                return;
+            }
+            framesSent += numFrames;
+        }
+
+        RenderStream::Encoding encoding;
+        int framesPerBlock;
+        int bytesPerFrame;
+        SendFunc& send;
+        MemoryBlock pending;
+        int pendingFrames = 0;
+        int64& framesSent;
+        bool& sendFailed;
+    };
+
+    /** An AudioFormat that te::Renderer can write to, which creates a
+     StreamWriter instead of writing a file */
+    class StreamFormat : public AudioFormat {
+    public:
+        StreamFormat(RenderStream::Encoding encoding, int framesPerBlock, SendFunc send)
+        : AudioFormat("cybr stream", ".wav"), encoding(encoding), framesPerBlock(framesPerBlock), send(send) {}
+
+        Array<int> getPossibleSampleRates() override { return { 22050, 32000, 44100, 48000, 88200, 96000, 176400, 192000 }; }
+        Array<int> getPossibleBitDepths() override { return { 16, 24, 32 }; }
+        bool canDoStereo() override { return true; }
+        bool canDoMono() override { return true; }
+
+        AudioFormatReader* createReaderFor(InputStream* sourceStream, bool deleteStreamIfOpeningFails) override {
+            if (deleteStreamIfOpeningFails) delete sourceStream;
+            return nullptr;
+        }
+
+        AudioFormatWriter* createWriterFor(OutputStream* streamToWriteTo,
+                                           double sampleRateToUse,
+                                           unsigned int numberOfChannels,
+                                           int,
+                                           const StringPairArray&,
+                                           int) override {
+            began = true;
+            return new StreamWriter(streamToWriteTo, sampleRateToUse, numberOfChannels, encoding, framesPerBlock, send, framesSent, sendFailed);
+        }
+
+        bool began = false;
+        int64 framesSent = 0;
+        bool sendFailed = false;
+
+    private:
+        RenderStream::Encoding encoding;
+        int framesPerBlock;
+        SendFunc send;
+    };
+}
+
+bool RenderStream::parseEncoding(const String& name, Encoding& result) {
+    for (auto encoding : { float32, int16, int24 }) {
+        if (name == getEncodingName(encoding)) {
+            result = encoding;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* RenderStream::getEncodingName(Encoding encoding) {
+    switch (encoding) {
+        case float32: return "f32";
+        case int16:   return "s16";
+        case int24:   return "s24";
+    }
+    return "unknown";
+}
+
+int RenderStream::getBytesPerSample(Encoding encoding) {
+    switch (encoding) {
+        case float32: return 4;
+        case int16:   return 2;
+        case int24:   return 3;
+    }
+    return 4;
+}
+
+int64 RenderStream::renderTrackRegion(te::Track& track,
+                                      te::EditTimeRange range,
+                                      Encoding encoding,
+                                      int framesPerBlock,
+                                      std::function<bool(const OSCMessage&)> send) {
+    if (range.getLength() <= 0) {
+        CYBR_LOG(error, render, "Cannot stream track region: time range is zero.");
+        return -1;
+    }
+
+    BigInteger tracksToDo;
+    {
+        int i = 0;
+        track.edit.visitAllTracks([&i, &track, &tracksToDo] (te::Track& check) {
+            if (&track == &check) tracksToDo.setBit(i);
+            i++;
+            return true;
+        }, true);
+    }
+
+    // te::Renderer always writes to a file, but StreamFormat's writer
+    // ignores it, so the file stays empty.
+    TemporaryFile scratch(".wav");
+    StreamFormat format(encoding, jmax(1, framesPerBlock), send);
+
+    auto& dm = track.edit.engine.getDeviceManager();
+    te::Renderer::Parameters params(track.edit);
+    params.destFile = scratch.getFile();
+    params.audioFormat = &format;
+    params.bitDepth = 32;
+    params.blockSizeForAudio = dm.getBlockSize();
+    params.sampleRateForAudio = dm.getSampleRate();
+    params.time = range;
+    params.tracksToDo = tracksToDo;
+    params.usePlugins = true;
+    params.useMasterPlugins = true;
+    params.canRenderInMono = false;
+    params.ditheringEnabled = false;
+
+    String jobTitle = "Stream " + track.getName();
+    CYBR_LOG(info, render, jobTitle);
+    te::Renderer::renderToFile(jobTitle, params);
+    if (!format.began) {
+        CYBR_LOG(error, render, "Failed to stream: " << track.getName());
+        return -1;
+    }
+    if (format.sendFailed) {
+        CYBR_LOG(error, render, "Stopped streaming " << track.getName() << ": The receiver did not keep up");
+        return sendFailed;
+    }
+    return format.framesSent;
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    RenderStream.h
+    Created: 16 Oct 2026 9:00:12pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <functional>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Render a track to a sequence of OSC messages instead of a file, so the
+ receiver can use the audio before the render is finished.
+
+ The messages are:
+ /render/stream/begin (int sampleRate, int numChannels, string encoding)
+ /render/stream/block (int firstFrame, blob samples) - repeated
+ Samples are interleaved and little-endian. The encoding is one of "f32"
+ (32 bit float), "s16" or "s24" (signed integers).
+ */
+class RenderStream {
+public:
+    enum Encoding { float32, int16, int24 };
+
+    /** Parse "f32", "s16" or "s24". Returns false if name is not an encoding. */
+    static bool parseEncoding(const juce::String& name, Encoding& result);
+    static const char* getEncodingName(Encoding encoding);
+    static int getBytesPerSample(Encoding encoding);
+
+    /** Returned by renderTrackRegion when send failed */
+    static constexpr juce::int64 sendFailed = -2;
+
+    /** Render track over range, calling send with each message as soon as it
+     is ready, on the calling thread. Each block message holds up to
+     framesPerBlock frames. send returns false if the message could not be
+     sent, which stops the render. Returns the number of frames sent, -1 if
+     the render failed, or sendFailed. */
+    static juce::int64 renderTrackRegion(te::Track& track,
+                                         te::EditTimeRange range,
+                                         Encoding encoding,
+                                         int framesPerBlock,
+                                         std::function<bool(const juce::OSCMessage&)> send);
+};
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    StemRenderJob.cpp
+    Created: 16 Oct 2026 8:37:03pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "StemRenderJob.h"
+#include "cybr_helpers.h"
+#include "CybrLog.h"
+
+using namespace juce;
+
+const String StemRenderJob::workerOption{ "--render-stems-worker" };
+
+namespace {
+    /** Workers prefix their progress lines with this, so the parent can tell
+     them apart from anything else the worker prints */
+    const String progressPrefix{ "cybr-stem " };
+}
+
+StemRenderJob::StemRenderJob(te::Edit& edit,
+                             const Array<te::Track*>& tracks,
+                             const File& directory,
+                             te::EditTimeRange range,
+                             int numWorkers)
+: edit(edit), range(range) {
+    for (auto track : tracks) {
+        Stem stem;
+        stem.trackID = track->itemID;
+        stem.trackName = track->getName();
+        stem.file = directory.getChildFile(File::createLegalFileName(track->getName()) + ".wav");
+        stems.push_back(stem);
+    }
+    if (numWorkers <= 0) numWorkers = SystemStats::getNumCpus();
+    this->numWorkers = jlimit(1, jmax(1, (int)stems.size()), numWorkers);
+}
+
+int StemRenderJob::render() {
+    JUCE_ASSERT_MESSAGE_THREAD
+    const double startMs = Time::getMillisecondCounterHiRes();
+    for (auto& stem : stems) {
+        stem.finished = false;
+        stem.success = false;
+        stem.seconds = 0;
+    }
+    numFinished = 0;
+
+    int successes = numWorkers > 1 ? renderWithWorkers() : -1;
+    if (successes < 0) successes = renderInProcess();
+
+    wallSeconds = (Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+    CYBR_LOG(info, render, "Rendered " << successes << " of " << (int)stems.size() << " stems in "
+        << wallSeconds << " seconds with " << numWorkers << (numWorkers == 1 ? " process" : " worker processes"));
+    return successes;
+}
+
+int StemRenderJob::renderInProcess() {
+    numWorkers = 1;
+    int successes = 0;
+    for (int i = 0; i < (int)stems.size(); i++) {
+        Stem& stem = stems[i];
+        // Look the track up again, in case it was removed since the job was
+        // created
+        te::Track* track = te::findTrackForID(edit, stem.trackID);
+        if (!track) {
+            CYBR_LOG(error, render, "Cannot render stem: Track not found: " << stem.trackName);
+            finishStem(i, false, 0, successes);
+            continue;
+        }
+
+        const double stemStartMs = Time::getMillisecondCounterHiRes();
+        bool success = renderTrackRegion(stem.file, *track, range);
+        finishStem(i, success, (Time::getMillisecondCounterHiRes() - stemStartMs) / 1000.0, successes);
+    }
+    return successes;
+}
+
+int StemRenderJob::renderWithWorkers() {
+    File jobDirectory = File::getSpecialLocation(File::tempDirectory).getNonexistentChildFile("cybr-stems", {}, false);
+    if (!jobDirectory.createDirectory()) {
+        CYBR_LOG(warning, render, "Cannot start stem workers: Failed to create " << jobDirectory.getFullPathName());
+        return -1;
+    }
+
+    // The workers load the edit from a snapshot with absolute sample paths,
+    // so it does not matter where the snapshot is written
+    edit.flushState();
+    ValueTree snapshot = edit.state.createCopy();
+    resolveSnapshotSources(snapshot, edit);
+    File editFile = jobDirectory.getChildFile("stems.tracktionedit");
+    if (!writeEditSnapshot(snapshot, editFile, SamplePathMode::absolute)) {
+        CYBR_LOG(warning, render, "Cannot start stem workers: Failed to write " << editFile.getFullPathName());
+        jobDirectory.deleteRecursively();
+        return -1;
+    }
+
+    // Tracks are identified by their index, which is the same in the snapshot
+    const auto allTracks = te::getAllTracks(edit);
+    int successes = 0;
+    OwnedArray<ChildProcess> workers;
+    const String executable = File::getSpecialLocation(File::currentExecutableFile).getFullPathName();
+    for (int w = 0; w < numWorkers; w++) {
+        // Deal the stems out in turn, so each worker gets a similar number
+        Array<var> workerStems;
+        for (int i = w; i < (int)stems.size(); i += numWorkers) {
+            const int trackIndex = allTracks.indexOf(te::findTrackForID(edit, stems[i].trackID));
+            if (trackIndex < 0) {
+                CYBR_LOG(error, render, "Cannot render stem: Track not found: " << stems[i].trackName);
+                finishStem(i, false, 0, successes);
+                continue;
+            }
+            DynamicObject::Ptr workerStem = new DynamicObject();
+            workerStem->setProperty("stem", i);
+            workerStem->setProperty("track", trackIndex);
+            workerStem->setProperty("file", stems[i].file.getFullPathName());
+            workerStems.add(var(workerStem.get()));
+        }
+        if (workerStems.isEmpty()) continue;
+
+        DynamicObject::Ptr job = new DynamicObject();
+        job->setProperty("edit", editFile.getFullPathName());
+        job->setProperty("start", range.getStart());
+        job->setProperty("end", range.getEnd());
+        job->setProperty("stems", workerStems);
+        File jobFile = jobDirectory.getChildFile("worker-" + String(w) + ".json");
+        auto worker = std::make_unique<ChildProcess>();
+        if (!jobFile.replaceWithText(JSON::toString(var(job.get())))
+            || !worker->start(StringArray{ executable, workerOption + "=" + jobFile.getFullPathName() }, ChildProcess::wantStdOut)) {
+            CYBR_LOG(error, render, "Failed to start stem worker " << w);
+            // If nothing has started yet, the caller can fall back to
+            // rendering in this process
+            if (workers.isEmpty() && numFinished == 0) {
+                jobDirectory.deleteRecursively();
+                return -1;
+            }
+            for (const auto& workerStem : workerStems) finishStem(workerStem["stem"], false, 0, successes);
+            continue;
+        }
+        workers.add(worker.release());
+    }
+
+    // The workers run at the same time. Reading their output in turn only
+    // delays the progress lines of the later workers.
+    for (auto* worker : workers) {
+        char buffer[512];
+        String pending;
+        while (int numBytes = worker->readProcessOutput(buffer, sizeof(buffer))) {
+            pending += String::fromUTF8(buffer, numBytes);
+            int newline;
+            while ((newline = pending.indexOfChar('\n')) >= 0) {
+                const String line = pending.substring(0, newline).trim();
+                pending = pending.substring(newline + 1);
+                if (!line.startsWith(progressPrefix)) continue;
+                auto tokens = StringArray::fromTokens(line.substring(progressPrefix.length()), false);
+                const int index = tokens[0].getIntValue();
+                if (tokens.size() == 3 && isPositiveAndBelow(index, (int)stems.size()))
+                    finishStem(index, tokens[1] == "1", tokens[2].getDoubleValue(), successes);
+            }
+        }
+        worker->waitForProcessToFinish(-1);
+    }
+    jobDirectory.deleteRecursively();
+
+    // Stems that a worker never reported (if it crashed, for example) failed
+    for (int i = 0; i < (int)stems.size(); i++) {
+        if (stems[i].finished) continue;
+        CYBR_LOG(error, render, "Stem worker did not report: " << stems[i].trackName);
+        finishStem(i, false, 0, successes);
+    }
+    return successes;
+}
+
+void StemRenderJob::finishStem(int index, bool success, double seconds, int& successes) {
+    Stem& stem = stems[index];
+    if (stem.finished) return;
+    stem.finished = true;
+    stem.success = success;
+    stem.seconds = seconds;
+    numFinished++;
+    if (success) successes++;
+    CYBR_LOG(info, render, "Stem " << numFinished << "/" << (int)stems.size() << " "
+        << (success ? "rendered" : "failed") << ": " << stem.trackName
+        << " (" << seconds << "s)");
+}
+
+int StemRenderJob::runWorker(te::Engine& engine, const File& jobFile) {
+    var job = JSON::parse(jobFile);
+    File editFile(job["edit"].toString());
+    if (!job["stems"].isArray() || !editFile.existsAsFile()) {
+        std::cerr << "Invalid stem job file: " << jobFile.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    std::unique_ptr<te::Edit> workerEdit(createEdit(editFile, engine));
+    const te::EditTimeRange workerRange((double)job["start"], (double)job["end"]);
+    const auto allTracks = te::getAllTracks(*workerEdit);
+    int successes = 0;
+    for (const auto& workerStem : *job["stems"].getArray()) {
+        const double startMs = Time::getMillisecondCounterHiRes();
+        te::Track* track = allTracks[(int)workerStem["track"]];
+        bool success = track && renderTrackRegion(File(workerStem["file"].toString()), *track, workerRange);
+        if (success) successes++;
+        std::cout << progressPrefix << (int)workerStem["stem"] << " " << (success ? 1 : 0) << " "
+            << (Time::getMillisecondCounterHiRes() - startMs) / 1000.0 << std::endl;
+    }
+    return successes;
+}
+
+var StemRenderJob::getReport() const {
+    Array<var> stemReports;
+    for (const auto& stem : stems) {
+        DynamicObject::Ptr stemReport = new DynamicObject();
+        stemReport->setProperty("track", stem.trackName);
+        stemReport->setProperty("file", stem.file.getFullPathName());
+        stemReport->setProperty("success", stem.success);
+        stemReport->setProperty("seconds", stem.seconds);
+        stemReports.add(var(stemReport.get()));
+    }
+
+    DynamicObject::Ptr report = new DynamicObject();
+    report->setProperty("stems", stemReports);
+    report->setProperty("workers", numWorkers);
+    report->setProperty("wallSeconds", wallSeconds);
+    return var(report.get());
+}
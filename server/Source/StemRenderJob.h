@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    StemRenderJob.h
+    Created: 16 Oct 2026 8:37:03pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <vector>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Render several tracks of an edit to separate files.
+
+ te::Renderer must run on the message thread, and each pass renders one mix,
+ so one process can only render one stem at a time. To render stems at the
+ same time, the job writes a snapshot of the edit to a temporary file and fans
+ the stems out across worker processes (this executable, run with
+ --render-stems-worker). Each worker loads the snapshot once, and renders its
+ share of the stems. With one worker, the stems are rendered in this process.
+
+ Every method must be called on the message thread.
+ */
+class StemRenderJob {
+public:
+    struct Stem {
+        te::EditItemID trackID;
+        juce::String trackName;
+        juce::File file;
+        bool finished = false;
+        bool success = false;
+        double seconds = 0;
+    };
+
+    /** Prepare to render each track to directory/trackName.wav. If numWorkers
+     is 0, use one worker process per CPU, but no more than one per stem. */
+    StemRenderJob(te::Edit& edit,
+                  const juce::Array<te::Track*>& tracks,
+                  const juce::File& directory,
+                  te::EditTimeRange range,
+                  int numWorkers = 0);
+
+    /** Render every stem, blocking until they are all finished. Returns the
+     number of stems that rendered successfully. */
+    int render();
+
+    const std::vector<Stem>& getStems() const { return stems; }
+    int getNumWorkers() const { return numWorkers; }
+    double getWallSeconds() const { return wallSeconds; }
+
+    /** Get a JSON friendly summary of the most recent render */
+    juce::var getReport() const;
+
+    /** The CLI option that runs a worker. Its value is a job file written by
+     renderWithWorkers. */
+    static const juce::String workerOption;
+    /** Render the stems listed in a job file, printing one line per stem to
+     stdout for the parent process. Returns the number of stems rendered. */
+    static int runWorker(te::Engine& engine, const juce::File& jobFile);
+
+private:
+    /** Render every stem in this process, one after another */
+    int renderInProcess();
+    /** Render the stems in worker processes. Returns -1 if the workers could
+     not be started, in which case nothing was rendered. */
+    int renderWithWorkers();
+    /** Log the result of the stem at index, and count it if it succeeded */
+    void finishStem(int index, bool success, double seconds, int& successes);
+
+    te::Edit& edit;
+    std::vector<Stem> stems;
+    te::EditTimeRange range;
+    int numWorkers;
+    int numFinished = 0;
+    double wallSeconds = 0;
+};
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    TimestampedOscMessage.cpp
+    Created: 16 Oct 2026 9:09:49pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "TimestampedOscMessage.h"
+
+using namespace juce;
+
+bool TimestampedOscMessage::append(const void* src, size_t size, Bytes& result) {
+    if (size > (size_t)(maxBytes - numBytes)) return false;
+    memcpy(data + numBytes, src, size);
+    result = { (uint16)numBytes, (uint16)size };
+    numBytes += (int)size;
+    return true;
+}
+
+bool TimestampedOscMessage::set(const OSCMessage& message, double timeMs) {
+    arrivedAt = timeMs * 0.001;
+    streamTime = 0;
+    editTime = 0;
+    numArgs = 0;
+    numBytes = 0;
+    if (message.size() > maxArgs) return false;
+
+    // Strings are stored without their null terminators. copyToUTF8 writes
+    // one, so it needs a byte of headroom.
+    const String pattern = message.getAddressPattern().toString();
+    const size_t patternBytes = pattern.getNumBytesAsUTF8();
+    if (patternBytes + 1 > (size_t)maxBytes) return false;
+    pattern.copyToUTF8(data, maxBytes);
+    address = { 0, (uint16)patternBytes };
+    numBytes = (int)patternBytes;
+
+    for (const auto& arg : message) {
+        Arg& stored = args[numArgs];
+        stored.type = arg.getType();
+        if (arg.isInt32()) {
+            stored.intValue = arg.getInt32();
+        } else if (arg.isFloat32()) {
+            stored.floatValue = arg.getFloat32();
+        } else if (arg.isString()) {
+            const String s = arg.getString();
+            const size_t size = s.getNumBytesAsUTF8();
+            if (size + 1 > (size_t)(maxBytes - numBytes)) return false;
+            s.copyToUTF8(data + numBytes, (size_t)(maxBytes - numBytes));
+            stored.bytes = { (uint16)numBytes, (uint16)size };
+            numBytes += (int)size;
+        } else if (arg.isBlob()) {
+            const MemoryBlock& blob = arg.getBlob();
+            if (!append(blob.getData(), blob.getSize(), stored.bytes)) return false;
+        } else {
+            return false;
+        }
+        numArgs++;
+    }
+    return true;
+}
+
+bool TimestampedOscMessage::isNumber(int i) const {
+    return args[i].type == OSCTypes::int32 || args[i].type == OSCTypes::float32;
+}
+
+double TimestampedOscMessage::getNumber(int i) const {
+    if (args[i].type == OSCTypes::int32) return args[i].intValue;
+    if (args[i].type == OSCTypes::float32) return args[i].floatValue;
+    return 0;
+}
+
+String TimestampedOscMessage::getAddress() const {
+    return String::fromUTF8(data + address.offset, address.size);
+}
+
+String TimestampedOscMessage::getString(int i) const {
+    if (args[i].type != OSCTypes::string) return {};
+    return String::fromUTF8(data + args[i].bytes.offset, args[i].bytes.size);
+}
+
+MemoryBlock TimestampedOscMessage::getBlob(int i) const {
+    if (args[i].type != OSCTypes::blob) return {};
+    return MemoryBlock(data + args[i].bytes.offset, args[i].bytes.size);
+}
+
+var TimestampedOscMessage::getVar(int i) const {
+    // OSCTypes are not compile time constants, so they cannot be switched on
+    const OSCType type = args[i].type;
+    if (type == OSCTypes::int32) return args[i].intValue;
+    if (type == OSCTypes::float32) return args[i].floatValue;
+    if (type == OSCTypes::string) return getString(i);
+    if (type == OSCTypes::blob) return getBlob(i);
+    return {};
+}
+
+OSCMessage TimestampedOscMessage::toOscMessage() const {
+    OSCMessage message(getAddress());
+    for (int i = 0; i < numArgs; i++) {
+        const OSCType type = args[i].type;
+        if (type == OSCTypes::int32) message.addInt32(args[i].intValue);
+        else if (type == OSCTypes::float32) message.addFloat32(args[i].floatValue);
+        else if (type == OSCTypes::string) message.addString(getString(i));
+        else if (type == OSCTypes::blob) message.addBlob(getBlob(i));
+    }
+    return message;
+}
+
+String TimestampedOscMessage::toString() const {
+    String s(streamTime, 4);
+    s << " - " << getAddress();
+    for (int i = 0; i < numArgs; i++) {
+        if (args[i].type == OSCTypes::blob) s << " [blob " << (int)args[i].bytes.size << " bytes]";
+        else s << " " << getVar(i).toString();
+    }
+    return s;
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    TimestampedOscMessage.h
+    Created: 16 Oct 2026 9:09:49pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/** An OSC message and the times it arrived at, stored in a fixed size
+ object that can be copied without allocating. This lets full messages pass
+ through a LockFreeQueue on their way to and from the audio thread.
+
+ Supports int32, float32, string and blob arguments. The address, strings and
+ blobs share an arena of maxBytes.
+ */
+struct TimestampedOscMessage {
+    static constexpr int maxArgs = 8;
+    static constexpr int maxBytes = 256;
+
+    double arrivedAt = 0;
+    double streamTime = 0;
+    double editTime = 0;
+
+    /** Copy message without allocating, and set arrivedAt from timeMs.
+     Returns false if the message has more than maxArgs arguments, an
+     unsupported argument type, or does not fit in maxBytes. */
+    bool set(const juce::OSCMessage& message, double timeMs);
+    /** Create a juce::OSCMessage from this one. This allocates. */
+    juce::OSCMessage toOscMessage() const;
+
+    int getNumArgs() const { return numArgs; }
+    juce::OSCType getType(int i) const { return args[i].type; }
+    bool isNumber(int i) const;
+    juce::int32 getInt32(int i) const { return args[i].intValue; }
+    float getFloat32(int i) const { return args[i].floatValue; }
+    /** Get an int32 or float32 argument as a double */
+    double getNumber(int i) const;
+
+    // The following allocate, so call them off the audio thread
+    juce::String getAddress() const;
+    juce::String getString(int i) const;
+    juce::MemoryBlock getBlob(int i) const;
+    /** Get any argument as a var (blobs become a MemoryBlock) */
+    juce::var getVar(int i) const;
+    juce::String toString() const;
+
+private:
+    struct Bytes {
+        juce::uint16 offset;
+        juce::uint16 size;
+    };
+    struct Arg {
+        juce::OSCType type;
+        union {
+            juce::int32 intValue;
+            float floatValue;
+            Bytes bytes;
+        };
+    };
+
+    bool append(const void* src, size_t size, Bytes& result);
+
+    Arg args[maxArgs];
+    int numArgs = 0;
+    Bytes address { 0, 0 };
+    int numBytes = 0;
+    char data[maxBytes];
+};
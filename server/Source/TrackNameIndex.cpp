@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    TrackNameIndex.cpp
+    Created: 16 Oct 2026 8:40:39pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#include "TrackNameIndex.h"
+
+using namespace juce;
+
+TrackNameIndex::TrackNameIndex(te::Edit& e) : edit(e), editState(e.state) {
+    editState.addListener(this);
+}
+
+TrackNameIndex::~TrackNameIndex() {
+    editState.removeListener(this);
+}
+
+te::AudioTrack* TrackNameIndex::findAudioTrack(const String& name, te::FolderTrack* parent) {
+    return dynamic_cast<te::AudioTrack*>(find('a', name, parent));
+}
+
+te::FolderTrack* TrackNameIndex::findSubmix(const String& name, te::FolderTrack* parent) {
+    return dynamic_cast<te::FolderTrack*>(find('s', name, parent));
+}
+
+te::Track* TrackNameIndex::find(char type, const String& name, te::FolderTrack* parent) {
+    update();
+    auto found = tracks.find(createKey(type, name, parent));
+    if (found == tracks.end()) return nullptr;
+
+    // A renamed track leaves its old key behind. If that happens, rebuild.
+    te::Track* track = found->second;
+    if (track->getName() == name) return track;
+    needsRebuild = true;
+    return find(type, name, parent);
+}
+
+void TrackNameIndex::update() {
+    if (!needsRebuild) {
+        for (const auto& tree : pendingTracks) {
+            te::Track* track = te::findTrackForID(edit, te::EditItemID::fromID(tree));
+            if (track && !add(*track)) {
+                needsRebuild = true;
+                break;
+            }
+        }
+    }
+    pendingTracks.clear();
+    if (needsRebuild) rebuild();
+}
+
+void TrackNameIndex::rebuild() {
+    tracks.clear();
+    for (auto track : te::getAllTracks(edit)) add(*track);
+    needsRebuild = false;
+}
+
+bool TrackNameIndex::add(te::Track& track) {
+    const char type = getType(track);
+    if (!type) return true;
+
+    bool isNew = true;
+    const String name = track.getName();
+    auto addKey = [this, &track, &isNew](const String& key) {
+        auto result = tracks.emplace(key, &track);
+        if (!result.second && result.first->second != &track) isNew = false;
+    };
+    addKey(createKey(type, name, nullptr));
+    te::FolderTrack* parent = track.getParentFolderTrack();
+    if (parent && parent->isSubmixFolder()) addKey(createKey(type, name, parent));
+    return isNew;
+}
+
+char TrackNameIndex::getType(te::Track& track) {
+    if (dynamic_cast<te::AudioTrack*>(&track)) return 'a';
+    if (auto folder = dynamic_cast<te::FolderTrack*>(&track)) {
+        if (folder->isSubmixFolder()) return 's';
+    }
+    return 0;
+}
+
+String TrackNameIndex::createKey(char type, const String& name, te::FolderTrack* parent) {
+    return String::charToString(type)
+        + String::toHexString((pointer_sized_int) parent)
+        + "/" + name;
+}
+
+void TrackNameIndex::valueTreePropertyChanged(ValueTree& tree, const Identifier& property) {
+    if (property == te::IDs::name && te::TrackList::isTrack(tree)) pendingTracks.push_back(tree);
+}
+
+void TrackNameIndex::valueTreeChildAdded(ValueTree&, ValueTree& child) {
+    if (!te::TrackList::isTrack(child)) return;
+    pendingTracks.push_back(child);
+    // Tracks nested inside a newly added folder do not get their own callback
+    for (auto grandchild : child) {
+        if (te::TrackList::isTrack(grandchild)) needsRebuild = true;
+    }
+}
+
+void TrackNameIndex::valueTreeChildRemoved(ValueTree&, ValueTree& child, int) {
+    if (te::TrackList::isTrack(child)) {
+        needsRebuild = true;
+        withWidthPlugin.clear();
+    } else if (child.hasType(te::IDs::PLUGIN)) {
+        withWidthPlugin.clear();
+    }
+}
+
+void TrackNameIndex::valueTreeChildOrderChanged(ValueTree& parent, int, int) {
+    if (parent == editState || te::TrackList::isTrack(parent)) needsRebuild = true;
+}
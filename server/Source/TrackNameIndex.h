@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    TrackNameIndex.h
+    Created: 16 Oct 2026 8:40:39pm
+    Author:  agent
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+namespace te = tracktion_engine;
+
+/** Look up audio tracks and submix tracks by name without scanning the edit.
+
+ Lookups match the linear searches in getOrCreateAudioTrackByName and
+ getOrCreateSubmixByName: with no parent, return the first matching track in
+ edit order; with a parent, only check that submix's immediate children.
+
+ The index listens to the edit's ValueTree. New and renamed tracks are added
+ to the index the next time it is used. Removing or moving tracks causes the
+ index to be rebuilt on the next lookup. Message thread only.
+ */
+class TrackNameIndex : private juce::ValueTree::Listener {
+public:
+    TrackNameIndex(te::Edit& edit);
+    ~TrackNameIndex();
+
+    te::AudioTrack* findAudioTrack(const juce::String& name, te::FolderTrack* parent = nullptr);
+    te::FolderTrack* findSubmix(const juce::String& name, te::FolderTrack* parent = nullptr);
+
+    /** ensureWidthPlugin scans the plugin list, so remember which tracks have
+     already been checked. Forgotten whenever a plugin is removed. */
+    bool hasWidthPlugin(te::Track& track) const { return withWidthPlugin.count(&track) > 0; }
+    void setHasWidthPlugin(te::Track& track) { withWidthPlugin.insert(&track); }
+
+private:
+    te::Track* find(char type, const juce::String& name, te::FolderTrack* parent);
+    void update();
+    void rebuild();
+    /** Add a track's keys. Returns false if a key already belonged to another
+     track, in which case edit order is unknown, and the index must be rebuilt. */
+    bool add(te::Track& track);
+    static char getType(te::Track& track);
+    static juce::String createKey(char type, const juce::String& name, te::FolderTrack* parent);
+
+    void valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree& parent, juce::ValueTree& child) override;
+    void valueTreeChildRemoved(juce::ValueTree& parent, juce::ValueTree& child, int index) override;
+    void valueTreeChildOrderChanged(juce::ValueTree& parent, int oldIndex, int newIndex) override;
+
+    struct StringHash {
+        size_t operator()(const juce::String& s) const noexcept { return (size_t) s.hashCode64(); }
+    };
+
+    te::Edit& edit;
+    juce::ValueTree editState;
+    bool needsRebuild = true;
+    std::vector<juce::ValueTree> pendingTracks;
+    std::unordered_map<juce::String, te::Track*, StringHash> tracks;
+    std::unordered_set<te::Track*> withWidthPlugin;
+};
@@ -10,13 +10,14 @@
 
 #include "cybr_helpers.h"
 #include "CybrSearchPath.h"
+#include "CybrLog.h"
 
 using namespace juce;
 
 // Creates a new edit, and leaves deletion up to you
 te::Edit* createEmptyEdit(File inputFile, te::Engine& engine, te::Edit::EditRole role)
 {
-    std::cout << "Creating Edit Object" << std::endl;
+    CYBR_LOG(info, edit, "Creating Edit Object");
     te::Edit::Options editOptions{ engine };
     editOptions.editProjectItemID = te::ProjectItemID::createNewID(0);
     editOptions.editState = te::createEmptyEdit(engine);
@@ -27,14 +28,24 @@ te::Edit* createEmptyEdit(File inputFile, te::Engine& engine, te::Edit::EditRole
 }
 
 // Creates a new edit, and leaves deletion up to you
-te::Edit* createEdit(File inputFile, te::Engine& engine, te::Edit::EditRole role) {
+te::Edit* createEdit(File inputFile, te::Engine& engine, te::Edit::EditRole role, bool useSnapshot) {
+    // Snapshots are written from edits that were already loaded by this
+    // function, so their clip sources are already direct file references.
+    ValueTree valueTree;
+    bool fromSnapshot = false;
+    if (useSnapshot && hasFreshEditSnapshot(inputFile)) {
+        valueTree = readEditSnapshotBinary(getEditSnapshotFile(inputFile));
+        fromSnapshot = valueTree.isValid();
+        if (fromSnapshot) CYBR_LOG(info, edit, "Using edit snapshot: " << getEditSnapshotFile(inputFile).getFullPathName());
+    }
+
     // we are assuming the file exists.
-    ValueTree valueTree = te::loadEditFromFile(engine, inputFile, te::ProjectItemID::createNewID(0));
+    if (!fromSnapshot) valueTree = te::loadEditFromFile(engine, inputFile, te::ProjectItemID::createNewID(0));
 
     // Create the edit object.
     // Note we cannot save an edit file without and edit file retriever. It is
     // also used resolves audioclips that have source='./any/relative/path.wav'.
-    std::cout << "Creating Edit Object" << std::endl;
+    CYBR_LOG(info, edit, "Creating Edit Object");
     te::Edit::Options editOptions{ engine };
     editOptions.editProjectItemID = te::ProjectItemID::createNewID(0);
     editOptions.editState = valueTree;
@@ -46,15 +57,20 @@ te::Edit* createEdit(File inputFile, te::Engine& engine, te::Edit::EditRole role
     // By default (and for simplicity), all clips in an in-memory edit should
     // have a source property with an absolute path value. We want to avoid
     // clip sources with project ids or relative path values.
-    setClipAndSamplerSourcesToDirectFileReferences(*newEdit, SamplePathMode::absolute, false);
+    if (!fromSnapshot) setClipAndSamplerSourcesToDirectFileReferences(*newEdit, SamplePathMode::absolute, false);
+
+    // Older edits implement stereo width with a rack on every track
+    if (int numMigrated = migrateWidthRacks(*newEdit)) {
+        CYBR_LOG(info, edit, "Replaced " << numMigrated << " width rack(s) with the cybr-width plugin");
+    }
 
     // List any missing plugins
     for (auto plugin : newEdit->getPluginCache().getPlugins()) {
         if (plugin->isMissing()) {
-            std::cout << "WARNING! Edit contains this plugin, which is missing from the host: " << plugin->getName() << std::endl;
+            CYBR_LOG(warning, edit, "WARNING! Edit contains this plugin, which is missing from the host: " << plugin->getName());
         }
     }
-    std::cout << "Loaded edit file: " << inputFile.getFullPathName() << std::endl << std::endl;
+    CYBR_LOG(info, edit, "Loaded edit file: " << inputFile.getFullPathName());
     return newEdit;
 }
 
@@ -76,14 +92,130 @@ CybrEdit* copyCybrEditForPlayback(CybrEdit& cybrEdit) {
     return newCybrEdit;
 }
 
+namespace {
+    bool isSourceTree(const ValueTree& tree) {
+        return (tree.hasType(te::IDs::AUDIOCLIP) || tree.hasType(te::IDs::SOUND)) && tree.hasProperty(te::IDs::source);
+    }
+
+    void rewriteSnapshotSources(ValueTree tree, const File& outputDir, SamplePathMode mode) {
+        if (isSourceTree(tree)) {
+            // resolveSnapshotSources made every source absolute
+            String oldPath = tree[te::IDs::source];
+            File file(oldPath);
+
+            bool useRelativePath;
+            if (mode == SamplePathMode::relative) useRelativePath = true;
+            else if (mode == SamplePathMode::absolute) useRelativePath = false;
+            else useRelativePath = file.isAChildOf(outputDir);
+
+            String newPath = useRelativePath
+                ? file.getRelativePathFrom(outputDir)
+                : file.getFullPathName();
+            if (newPath != oldPath) tree.setProperty(te::IDs::source, newPath, nullptr);
+        }
+        for (auto child : tree) rewriteSnapshotSources(child, outputDir, mode);
+    }
+}
+
+void resolveSnapshotSources(ValueTree snapshot, te::Edit& edit) {
+    if (isSourceTree(snapshot)) {
+        String oldPath = snapshot[te::IDs::source];
+        File file = edit.filePathResolver(oldPath);
+        if (file != File()) snapshot.setProperty(te::IDs::source, file.getFullPathName(), nullptr);
+    }
+    for (auto child : snapshot) resolveSnapshotSources(child, edit);
+}
+
+bool writeEditSnapshot(ValueTree snapshot, File outputFile, SamplePathMode mode) {
+    rewriteSnapshotSources(snapshot, outputFile.getParentDirectory(), mode);
+
+    std::unique_ptr<XmlElement> xml = snapshot.createXml();
+    if (!xml) return false;
+
+    TemporaryFile temp(outputFile);
+    if (!xml->writeTo(temp.getFile())) return false;
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+File getEditSnapshotFile(const File& editFile) {
+    return editFile.getSiblingFile(editFile.getFileName() + ".snapshot");
+}
+
+EditFileStamp EditFileStamp::of(const File& editFile) {
+    EditFileStamp stamp;
+    stamp.modifiedMs = editFile.getLastModificationTime().toMilliseconds();
+    stamp.size = editFile.getSize();
+    return stamp;
+}
+
+namespace {
+    const char* const snapshotMagic = "CYBRSNAP";
+    const int snapshotVersion = 2;
+
+    /** Read the snapshot header, leaving stream at the start of the state */
+    bool readSnapshotHeader(FileInputStream& stream, EditFileStamp& stamp) {
+        if (stream.failedToOpen()) return false;
+        char magic[8];
+        if (stream.read(magic, 8) != 8 || memcmp(magic, snapshotMagic, 8) != 0) return false;
+        if (stream.readInt() != snapshotVersion) return false;
+        stamp.modifiedMs = stream.readInt64();
+        stamp.size = stream.readInt64();
+        return !stream.isExhausted();
+    }
+}
+
+bool hasFreshEditSnapshot(const File& editFile) {
+    // Compare for equality rather than checking that the snapshot is newer,
+    // because the XML may change within one tick of a coarse file system clock
+    FileInputStream fileStream(getEditSnapshotFile(editFile));
+    EditFileStamp stamp;
+    return readSnapshotHeader(fileStream, stamp) && stamp == EditFileStamp::of(editFile);
+}
+
+bool writeEditSnapshotBinary(const ValueTree& state, const File& snapshotFile, EditFileStamp stamp) {
+    TemporaryFile temp(snapshotFile);
+    {
+        FileOutputStream fileStream(temp.getFile());
+        if (fileStream.failedToOpen()) return false;
+        fileStream.write(snapshotMagic, 8);
+        fileStream.writeInt(snapshotVersion);
+        fileStream.writeInt64(stamp.modifiedMs);
+        fileStream.writeInt64(stamp.size);
+        GZIPCompressorOutputStream zipStream(fileStream, 1);
+        state.writeToStream(zipStream);
+        zipStream.flush();
+        if (fileStream.getStatus().failed()) return false;
+    }
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+ValueTree readEditSnapshotBinary(const File& snapshotFile) {
+    FileInputStream fileStream(snapshotFile);
+    EditFileStamp stamp;
+    if (!readSnapshotHeader(fileStream, stamp)) return {};
+
+    GZIPDecompressorInputStream zipStream(fileStream);
+    return ValueTree::readFromStream(zipStream);
+}
+
+uint64 getStateFingerprint(const ValueTree& state) {
+    MemoryOutputStream stream;
+    state.writeToStream(stream);
+    // 64 bit FNV-1a
+    uint64 hash = 14695981039346656037ULL;
+    auto data = static_cast<const uint8*>(stream.getData());
+    for (size_t i = 0; i < stream.getDataSize(); i++) hash = (hash ^ data[i]) * 1099511628211ULL;
+    return hash;
+}
+
 void setClipAndSamplerSourcesToDirectFileReferences(te::Edit& changeEdit, SamplePathMode mode, bool verbose)
 {
     int failures = 0;
     if (verbose) {
-        std::cout << "Searching for audio clips and updating their sources ";
-        if (mode == SamplePathMode::absolute) std::cout << "to absolute paths" << std::endl;
-        if (mode == SamplePathMode::relative) std::cout << "to relative paths" << std::endl;
-        if (mode == SamplePathMode::decide) std::cout << "to absolute paths, if sample is not in a subdirectory" << std::endl;
+        String target = "to absolute paths, if sample is not in a subdirectory";
+        if (mode == SamplePathMode::absolute) target = "to absolute paths";
+        if (mode == SamplePathMode::relative) target = "to relative paths";
+        CYBR_LOG(info, files, "Searching for audio clips and updating their sources " << target);
     }
 
     for (auto track : te::getClipTracks(changeEdit)) { // for each track
@@ -94,9 +226,8 @@ void setClipAndSamplerSourcesToDirectFileReferences(te::Edit& changeEdit, Sample
                 if (file == File()) {
                     // We failed to get the filepath from the project manager
                     failures++;
-                    std::cout
-                        << "ERROR: Failed to find and update source clip: " << audioClip->getName()
-                        << " source=\"" << sourceFileRef.source << "\"" << std::endl;
+                    CYBR_LOG(error, files, "ERROR: Failed to find and update source clip: " << audioClip->getName()
+                        << " source=\"" << sourceFileRef.source << "\"");
                 }
                 else {
                     bool useRelativePath;
@@ -120,13 +251,11 @@ void setClipAndSamplerSourcesToDirectFileReferences(te::Edit& changeEdit, Sample
                     sourceFileRef.setToDirectFileReference(file, useRelativePath); // assertion breakpoint if edit file DNE
                     if (original != sourceFileRef.source) {
                         audioClip->sourceMediaChanged(); // what does this really do, and is it needed?
-                        if (verbose) std::cout
-                            << "Updated \"" << original
-                            << "\" to \"" << sourceFileRef.source << "\"" << std::endl;
+                        if (verbose) CYBR_LOG(info, files, "Updated \"" << original
+                            << "\" to \"" << sourceFileRef.source << "\"");
                     }
                     else {
-                        if (verbose) std::cout
-                            << "Unchanged path: " << sourceFileRef.source << std::endl;
+                        if (verbose) CYBR_LOG(info, files, "Unchanged path: " << sourceFileRef.source);
                     }
                 }
             }
@@ -154,22 +283,19 @@ void setClipAndSamplerSourcesToDirectFileReferences(te::Edit& changeEdit, Sample
                 String newPath = te::SourceFileReference::findPathFromFile(changeEdit, soundFile, useRelativePath);
                 if (oldPath != newPath && newPath.isNotEmpty()) {
                     child.setProperty(te::IDs::source, newPath, nullptr);
-                    if (verbose) std::cout
-                        << "Updated sampler plugin source \"" << oldPath
-                        << "\" to \""  << newPath << "\"" << std::endl;
+                    if (verbose) CYBR_LOG(info, files, "Updated sampler plugin source \"" << oldPath
+                        << "\" to \""  << newPath << "\"");
                 }
             }
         }
     }
 
     if (failures > 0) {
-        std::cerr
-        << "ERROR: not all source clips could be identified!" << std::endl
+        CYBR_LOG(error, files, "ERROR: not all source clips could be identified!" << std::endl
         << "In my testing on windows, this happens when any of the following are true:" << std::endl
         << "- App is not aware of the project manager (try --autodetect-pm)" << std::endl
-        << "- The uid is not found by the project manager" << std::endl;
+        << "- The uid is not found by the project manager");
     }
-    if (verbose) std::cout << std::endl;
 }
 
 void autodetectPmSettings(te::Engine& engine)
@@ -499,7 +625,7 @@ void saveTracktionPreset(te::Plugin* plugin, String name) {
 
     Array<File> presetDirs = CybrSearchPath(CYBR_PRESET).paths();
     if (presetDirs.size() < 1) {
-        std::cout << "Cannot save preset. No preset paths found" << std::endl;
+        CYBR_LOG(error, plugin, "Cannot save preset. No preset paths found");
         return;
     }
 
@@ -509,9 +635,8 @@ void saveTracktionPreset(te::Plugin* plugin, String name) {
     File saveDir = file.getParentDirectory();
 
     if (!file.hasWriteAccess()) {
-        std::cout
-            << "Cannot write preset file (do not have write access): "
-            << file.getFullPathName() << std::endl;
+        CYBR_LOG(error, plugin, "Cannot write preset file (do not have write access): "
+            << file.getFullPathName());
         return;
     }
     ValueTree state(te::IDs::PRESET);
@@ -523,105 +648,12 @@ void saveTracktionPreset(te::Plugin* plugin, String name) {
     state.setProperty(te::IDs::tags, "cybr", nullptr);
 
     state.createXml()->writeTo(file);
-    std::cout << "Save tracktion preset: " << file.getFullPathName() << std::endl;
+    CYBR_LOG(info, plugin, "Save tracktion preset: " << file.getFullPathName());
 }
 
-te::RackType::Ptr ensureWidthRack(te::Track& track) {
-    for (auto plugin : track.pluginList) {
-        if (auto rack = dynamic_cast<te::RackInstance*>(plugin)) {
-            if (rack->state.hasProperty("cybr-width")) {
-                return track.edit.getRackList().getRackTypeForID(rack->rackTypeID);
-            }
-        }
-    }
-
-    te::RackType::Ptr cybrRackType = track.edit.getRackList().addNewRack();
-    {
-        cybrRackType->rackName.setValue("width", nullptr);
-        auto pluginMain = track.edit.getPluginCache().createNewPlugin("volume", PluginDescription());
-        auto plugin1 = track.edit.getPluginCache().createNewPlugin("volume", PluginDescription());
-        auto plugin2 = track.edit.getPluginCache().createNewPlugin("volume", PluginDescription());
-        auto plugin3 = track.edit.getPluginCache().createNewPlugin("volume", PluginDescription());
-        auto plugin4 = track.edit.getPluginCache().createNewPlugin("volume", PluginDescription());
-
-        auto volumeMain = dynamic_cast<te::VolumeAndPanPlugin*>(pluginMain.get());
-        auto volume1 = dynamic_cast<te::VolumeAndPanPlugin*>(plugin1.get());
-        auto volume2 = dynamic_cast<te::VolumeAndPanPlugin*>(plugin2.get());
-        auto volume3 = dynamic_cast<te::VolumeAndPanPlugin*>(plugin3.get());
-        auto volume4 = dynamic_cast<te::VolumeAndPanPlugin*>(plugin4.get());
-
-        volume1->setVolumeDb(-6.020599913279624);
-        volume2->setVolumeDb(-6.020599913279624);
-        volume3->setVolumeDb(-6.020599913279624);
-        volume4->setVolumeDb(-6.020599913279624);
-
-        // Note that we do not actually hard pan the two volume channels. This
-        // is accomplished with macros.
-
-        cybrRackType->addPlugin(pluginMain, {0.85, 0.5}, false);
-        cybrRackType->addPlugin(plugin1, {0.15, 0.35}, false);
-        cybrRackType->addPlugin(plugin2, {0.15, 0.60}, false);
-        cybrRackType->addPlugin(plugin3, {0.6, 0.35}, false);
-        cybrRackType->addPlugin(plugin4, {0.6, 0.60}, false);
-
-        // Left input channel to volume1
-        cybrRackType->addConnection({}, 1, volume1->itemID, 1);
-        cybrRackType->addConnection({}, 1, volume1->itemID, 2);
-        // Right input channel to volume2
-        cybrRackType->addConnection({}, 2, volume2->itemID, 1);
-        cybrRackType->addConnection({}, 2, volume2->itemID, 2);
-
-        // From 1 to 3, 4
-        cybrRackType->addConnection(volume1->itemID, 1, volume3->itemID, 1);
-        cybrRackType->addConnection(volume1->itemID, 1, volume3->itemID, 2);
-        cybrRackType->addConnection(volume1->itemID, 2, volume4->itemID, 1);
-        cybrRackType->addConnection(volume1->itemID, 2, volume4->itemID, 2);
-        // From 2 to 3, 4
-        cybrRackType->addConnection(volume2->itemID, 1, volume3->itemID, 1);
-        cybrRackType->addConnection(volume2->itemID, 1, volume3->itemID, 2);
-        cybrRackType->addConnection(volume2->itemID, 2, volume4->itemID, 1);
-        cybrRackType->addConnection(volume2->itemID, 2, volume4->itemID, 2);
-
-        // volume 3,4 to final gain stage
-        cybrRackType->addConnection(volume3->itemID, 1, volumeMain->itemID, 1);
-        cybrRackType->addConnection(volume3->itemID, 2, volumeMain->itemID, 2);
-        cybrRackType->addConnection(volume4->itemID, 1, volumeMain->itemID, 1);
-        cybrRackType->addConnection(volume4->itemID, 2, volumeMain->itemID, 2);
-
-        // final gain stage to Rack output
-        cybrRackType->addConnection(volumeMain->itemID, 1, {}, 1);
-        cybrRackType->addConnection(volumeMain->itemID, 2, {}, 2);
-
-        // route midi directly
-        cybrRackType->addConnection({}, 0, {}, 0);
-
-        // Create a macro in the rack
-        auto widthMacro = track.macroParameterList.createMacroParameter();
-        widthMacro->macroName = "width";
-        widthMacro->setParameter(1.0, juce::NotificationType::sendNotificationSync);
-        volume1->panParam->addModifier(*widthMacro, -1,  0.5);
-        volume2->panParam->addModifier(*widthMacro,  1, -0.5);
-
-        // Create a macro on the track
-        auto autoMacro = track.macroParameterList.createMacroParameter();
-        autoMacro->macroName = "width automation";
-        autoMacro->setParameter(1.0, juce::NotificationType::sendNotificationSync);
-        volume3->panParam->addModifier(*autoMacro, -1,  0.5);
-        volume4->panParam->addModifier(*autoMacro,  1, -0.5);
-
-        // Make the pan automation macro while we're here
-        auto panMacro = track.macroParameterList.createMacroParameter();
-        panMacro->macroName = "pan automation";
-        panMacro->setParameter(0.5, juce::NotificationType::sendNotificationSync);
-
-        auto volumePlugin  = track.pluginList.getPluginsOfType<te::VolumeAndPanPlugin>().getLast();
-        jassert(volumePlugin);
-        if (volumePlugin) {
-            volumePlugin->panParam->addModifier(*panMacro, 1, -0.5);
-        } else {
-            std::cout << "DANGER: ensureWidthRack couldn't find a volume plugin" << std::endl;
-        }
-    }
+CybrWidthPlugin* ensureWidthPlugin(te::Track& track) {
+    if (auto plugin = track.pluginList.getPluginsOfType<CybrWidthPlugin>().getFirst()) return plugin;
+    if (auto plugin = migrateWidthRack(track)) return plugin;
 
     // find the last volume plugin in the track
     int insertPoint = track.pluginList.size() - 1;
@@ -630,12 +662,89 @@ te::RackType::Ptr ensureWidthRack(te::Track& track) {
         if (auto x = dynamic_cast<te::VolumeAndPanPlugin*>(checkPlugin)) break;
     }
 
-    auto pluginTree = te::RackInstance::create(*cybrRackType.get());  // <PLUGIN type="rack" rackType="1002"/>
-    pluginTree.setProperty("cybr-width", "T", nullptr);
-    te::Plugin::Ptr plugin = track.edit.getPluginCache().createNewPlugin(pluginTree);
+    te::Plugin::Ptr plugin = track.edit.getPluginCache().createNewPlugin(CybrWidthPlugin::create());
     track.pluginList.insertPlugin(plugin, insertPoint, nullptr);
+    return dynamic_cast<CybrWidthPlugin*>(plugin.get());
+}
+
+te::MacroParameter* ensurePanAutomationMacro(te::Track& track) {
+    for (auto macro : track.macroParameterList.getMacroParameters()) {
+        if (macro->macroName == "pan automation") return macro;
+    }
+
+    auto volumePlugin = track.pluginList.getPluginsOfType<te::VolumeAndPanPlugin>().getLast();
+    if (!volumePlugin) {
+        CYBR_LOG(error, plugin, "Cannot create pan automation: track has no volume plugin: " << track.getName());
+        return nullptr;
+    }
+    auto panMacro = track.macroParameterList.createMacroParameter();
+    panMacro->macroName = "pan automation";
+    panMacro->setParameter(0.5, juce::NotificationType::sendNotificationSync);
+    volumePlugin->panParam->addModifier(*panMacro, 1, -0.5);
+    return panMacro;
+}
+
+namespace {
+    /** Copy a macro's value and automation to a parameter. The width rack's
+     macros are normalized, so their values are converted to param's range. */
+    void copyMacroToParam(te::MacroParameter* macro, te::AutomatableParameter::Ptr param) {
+        if (!macro) return;
+        param->setNormalisedParameter(macro->getCurrentValue(), juce::NotificationType::sendNotificationSync);
+        te::AutomationCurve& macroCurve = macro->getCurve();
+        te::AutomationCurve& paramCurve = param->getCurve();
+        for (int i = 0; i < macroCurve.getNumPoints(); i++) {
+            auto point = macroCurve.getPoint(i);
+            paramCurve.addPoint(point.time, param->valueRange.convertFrom0to1(point.value), point.curve);
+        }
+    }
+}
+
+CybrWidthPlugin* migrateWidthRack(te::Track& track) {
+    te::RackInstance* rack = nullptr;
+    int rackIndex = 0;
+    for (auto plugin : track.pluginList) {
+        if (plugin->state.hasProperty("cybr-width")) {
+            rack = dynamic_cast<te::RackInstance*>(plugin);
+            if (rack) break;
+        }
+        rackIndex++;
+    }
+    if (!rack) return nullptr;
+
+    te::MacroParameter* widthMacro = nullptr;
+    te::MacroParameter* widthAutomationMacro = nullptr;
+    for (auto macro : track.macroParameterList.getMacroParameters()) {
+        if (macro->macroName == "width") widthMacro = macro;
+        else if (macro->macroName == "width automation") widthAutomationMacro = macro;
+    }
+
+    te::Plugin::Ptr plugin = track.edit.getPluginCache().createNewPlugin(CybrWidthPlugin::create());
+    track.pluginList.insertPlugin(plugin, rackIndex, nullptr);
+    auto widthPlugin = dynamic_cast<CybrWidthPlugin*>(plugin.get());
+    jassert(widthPlugin);
+    if (!widthPlugin) return nullptr;
+
+    copyMacroToParam(widthMacro, widthPlugin->width);
+    copyMacroToParam(widthAutomationMacro, widthPlugin->widthAutomation);
+    // The pan automation macro modulates the volume plugin, not the rack, so
+    // it stays, and the track keeps its pan law and pan automation.
+
+    te::RackType::Ptr rackType = track.edit.getRackList().getRackTypeForID(rack->rackTypeID);
+    rack->deleteFromParent();
+    for (auto macro : { widthMacro, widthAutomationMacro }) {
+        if (macro) track.macroParameterList.removeMacroParameter(*macro);
+    }
+    // Each width rack type was only ever used by one track
+    if (rackType) track.edit.getRackList().removeRackType(rackType);
+    return widthPlugin;
+}
 
-    return cybrRackType;
+int migrateWidthRacks(te::Edit& edit) {
+    int count = 0;
+    for (auto track : te::getAllTracks(edit)) {
+        if (migrateWidthRack(*track)) count++;
+    }
+    return count;
 }
 
 void loadTracktionPreset(te::Track& audioTrack, ValueTree v) {
@@ -656,11 +765,11 @@ void loadTracktionPreset(te::Track& audioTrack, ValueTree v) {
         }
 
         if (name.isEmpty()) {
-            std::cout << "Cannot load plugin preset: plugin has invalid type: " << type << std::endl;
+            CYBR_LOG(error, plugin, "Cannot load plugin preset: plugin has invalid type: " << type);
             continue;
         }
 
-        std::cout << "Found preset: " << type << "/" << name << std::endl;
+        CYBR_LOG(info, plugin, "Found preset: " << type << "/" << name);
 
         if (te::Plugin* plugin = getOrCreatePluginByName(audioTrack, name, type)) {
             ValueTree currentConfig = plugin->state;
@@ -680,16 +789,15 @@ void loadTracktionPreset(te::Track& audioTrack, ValueTree v) {
             // have some mundane properties like windowLocked="1", enabled="1"
             plugin->restorePluginStateFromValueTree(preset);
 
-            std::cout << "Loaded preset: " << name << std::endl;
+            CYBR_LOG(info, plugin, "Loaded preset: " << name);
             loaded = true;
         } else {
-            std::cout << "Cannot load plugin preset: failed to create plugin with type/name: " << type << "/" << name << std::endl;
+            CYBR_LOG(error, plugin, "Cannot load plugin preset: failed to create plugin with type/name: " << type << "/" << name);
             continue;
         };
     }
-    if (loaded) std::cout
-        << "Loaded " << v[te::IDs::name].toString()
-        << " on " << audioTrack.getName() << std::endl;
+    if (loaded) CYBR_LOG(info, plugin, "Loaded " << v[te::IDs::name].toString()
+        << " on " << audioTrack.getName());
 }
 
 ValueTree loadXmlFile(File file) {
@@ -697,9 +805,9 @@ ValueTree loadXmlFile(File file) {
 
     if (file.existsAsFile()) {
         if (auto xml = XmlDocument::parse(file)) result = ValueTree::fromXml(*xml.get());
-        else std::cout << "Failed to parse xml in: " << file.getFullPathName() << std::endl;
+        else CYBR_LOG(error, files, "Failed to parse xml in: " << file.getFullPathName());
     } else {
-        std::cout << "File does not exist!" << std::endl;
+        CYBR_LOG(error, files, "File does not exist!");
     }
     return result;
 }
@@ -728,28 +836,29 @@ int ensureBus(te::Edit& edit, String busName) {
 }
 
 void printOscMessage(const OSCMessage& message) {
-    std::cout << message.getAddressPattern().toString();
+    String text = message.getAddressPattern().toString();
     for (const auto& arg : message) {
-        std::cout << " - ";
+        text << " - ";
         auto type = arg.getType();
-        if (type == OSCTypes::int32) std::cout << arg.getInt32();
-        else if (type == OSCTypes::string) std::cout << arg.getString();
-        else if (type == OSCTypes::float32) std::cout << arg.getFloat32();
-        else if (type == OSCTypes::blob) std::cout << arg.getBlob().toBase64Encoding();
+        if (type == OSCTypes::int32) text << arg.getInt32();
+        else if (type == OSCTypes::string) text << arg.getString();
+        else if (type == OSCTypes::float32) text << arg.getFloat32();
+        else if (type == OSCTypes::blob) text << arg.getBlob().toBase64Encoding();
         else if (type == OSCTypes::colour) {
             OSCColour c = arg.getColour();
-            std::cout << "RGBA("<< c.red << "," << c.green << "," << c.blue << "," << c.alpha << ")";
+            text << "RGBA(" << (int)c.red << "," << (int)c.green << "," << (int)c.blue << "," << (int)c.alpha << ")";
         }
     }
-    std::cout << std::endl;
+    CYBR_LOG(info, osc, text);
 };
 
-te::AudioTrack* getOrCreateAudioTrackByName(te::Edit& edit, const String name, const String submixName) {
+te::AudioTrack* getOrCreateAudioTrackByName(te::Edit& edit, const String name, const String submixName, TrackNameIndex* index) {
     te::AudioTrack* foundTrack = nullptr;
 
     if (submixName.isEmpty()) {
         // If no submix was specified, look recursively
-        for (auto* track : te::getAudioTracks(edit)) {
+        if (index) foundTrack = index->findAudioTrack(name);
+        else for (auto* track : te::getAudioTracks(edit)) {
             if (track->getName() != name) continue;
             foundTrack = track;
             break;
@@ -762,9 +871,9 @@ te::AudioTrack* getOrCreateAudioTrackByName(te::Edit& edit, const String name, c
         }
     } else {
         // A submix was specified. The parent, and look through its immediate children
-        auto* submixTrack = getOrCreateSubmixByName(edit, submixName);
-        auto checkTracks = submixTrack->getAllSubTracks(false);
-        for (auto* track : checkTracks) {
+        auto* submixTrack = getOrCreateSubmixByName(edit, submixName, String(), index);
+        if (index) foundTrack = index->findAudioTrack(name, submixTrack);
+        else for (auto* track : submixTrack->getAllSubTracks(false)) {
             if (auto* audioTrack = dynamic_cast<te::AudioTrack*>(track)) {
                 if (track->getName() == name) {
                     foundTrack = audioTrack;
@@ -780,14 +889,15 @@ te::AudioTrack* getOrCreateAudioTrackByName(te::Edit& edit, const String name, c
         }
     }
 
-    if (foundTrack) {
-        ensureWidthRack(*foundTrack);
+    if (foundTrack && !(index && index->hasWidthPlugin(*foundTrack))) {
+        ensureWidthPlugin(*foundTrack);
+        if (index) index->setHasWidthPlugin(*foundTrack);
     }
 
     return foundTrack;
 }
 
-te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const String name, const String submixName) {
+te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const String name, const String submixName, TrackNameIndex* index) {
     // In each of the steps below, if we find a suitable track, just return it.
     // If no suitable track was found, create a new submix track, inserting it
     // at the correct point, and put it in this variable. Before the final
@@ -797,7 +907,9 @@ te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const String name, cons
 
     if (submixName.isEmpty()) {
         // No parent was specified, so look for the submix recursively
-        for (auto* folderTrack : te::getTracksOfType<te::FolderTrack>(edit, true)){
+        if (index) {
+            if (auto* folderTrack = index->findSubmix(name)) return folderTrack;
+        } else for (auto* folderTrack : te::getTracksOfType<te::FolderTrack>(edit, true)){
             if (!folderTrack->isSubmixFolder()) continue;
             if (folderTrack->getName() == name) return folderTrack;
         }
@@ -807,10 +919,12 @@ te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const String name, cons
         newFolderTrack = edit.insertNewFolderTrack(insertPoint, nullptr, true);
     } else {
         // A parent was specified. Get or create the parent submix
-        te::FolderTrack* parent = getOrCreateSubmixByName(edit, submixName);
+        te::FolderTrack* parent = getOrCreateSubmixByName(edit, submixName, String(), index);
 
         // Check for a track in the parent's immediate (non-recursive) children
-        for (auto* track : parent->getAllSubTracks(false)) {
+        if (index) {
+            if (auto* folderTrack = index->findSubmix(name, parent)) return folderTrack;
+        } else for (auto* track : parent->getAllSubTracks(false)) {
             if (auto* folderTrack = dynamic_cast<te::FolderTrack*>(track)) {
                 if (!folderTrack->isSubmixFolder()) continue;
                 if (folderTrack->getName() == name) return folderTrack;
@@ -827,7 +941,8 @@ te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const String name, cons
     jassert(newFolderTrack);
 
     newFolderTrack->setName(name);
-    ensureWidthRack(*newFolderTrack);
+    ensureWidthPlugin(*newFolderTrack);
+    if (index) index->setHasWidthPlugin(*newFolderTrack);
     return newFolderTrack.get();
 }
 
@@ -841,7 +956,7 @@ te::MidiClip* getOrCreateMidiClipByName(te::ClipTrack& track, const String name)
     return clip;
 }
 
-te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const String type, const int index) {
+te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const String type, const int index, KnownPluginIndex* pluginIndex) {
     // To insert a plugin, we need two things:
     // (1) A PluginDescription. For internal plugins, a description is arbitrary
     PluginDescription foundPluginDesc;
@@ -858,19 +973,20 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
     // checkPlugin->getPluginType();   // "VST" or "VST3" of "AudioUnit"
     // checkPlugin->getName();         // "Zebra2"
 
-    // "width" is a special case, because the plugin is a Rack, and is not
-    // actually named "width". Note that indexing "width" is not supported.
+    // "width" is a special case, because every track has at most one width
+    // plugin, and it must stay after the other plugins. Note that indexing
+    // "width" is not supported.
     if ((name == "width" || name == "cybr-width") && (type.isEmpty() || type.equalsIgnoreCase("tracktion"))) {
-        ensureWidthRack(track);
-        for (auto plugin : track.pluginList) {
-            if (plugin->state.hasProperty("cybr-width")) {
-                return plugin;
-            }
-        }
+        return ensureWidthPlugin(track);
     }
 
     // first, search for a plugin that matches the full name (case insensitive)
-    for (PluginDescription desc : track.edit.engine.getPluginManager().knownPluginList.getTypes()) {
+    if (pluginIndex) {
+        if (pluginIndex->findExact(name, type, foundPluginDesc)) {
+            tracktionPluginType = te::ExternalPlugin::xmlTypeName;
+            foundIt = true;
+        }
+    } else for (PluginDescription desc : track.edit.engine.getPluginManager().knownPluginList.getTypes()) {
         if (desc.name.equalsIgnoreCase(name) && (type.isEmpty() || type.equalsIgnoreCase(desc.pluginFormatName))) {
             tracktionPluginType = te::ExternalPlugin::xmlTypeName;
             foundPluginDesc = desc;
@@ -881,8 +997,10 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
 
     // Next, check for "internal" plugins
     if (!foundIt && (type.isEmpty() || type.equalsIgnoreCase("tracktion"))) {
-        te::Plugin::Ptr internalPlugin = track.edit.getPluginCache().createNewPlugin(name, PluginDescription());
-        if (internalPlugin.get()) {
+        bool isInternal = pluginIndex
+            ? pluginIndex->isInternalType(track.edit, name)
+            : track.edit.getPluginCache().createNewPlugin(name, PluginDescription()).get() != nullptr;
+        if (isInternal) {
             tracktionPluginType = name;
             foundPluginDesc = PluginDescription();
             foundIt = true;
@@ -890,7 +1008,12 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
     }
 
     // If we still didn't find it, try looking for an external plugin using "startsWith"
-    if (!foundIt) {
+    if (!foundIt && pluginIndex) {
+        if (pluginIndex->findPrefix(name, type, foundPluginDesc)) {
+            tracktionPluginType = te::ExternalPlugin::xmlTypeName;
+            foundIt = true;
+        }
+    } else if (!foundIt) {
         for (PluginDescription desc : track.edit.engine.getPluginManager().knownPluginList.getTypes()) {
             if (desc.name.startsWithIgnoreCase(name) && (type.isEmpty() || type.equalsIgnoreCase(desc.pluginFormatName))) {
                 foundPluginDesc = desc;
@@ -903,7 +1026,7 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
 
     if (!foundIt) {
         String typeName = type.isEmpty() ? "any type" : type;
-        std::cout << "Plugin not found: " << name << " (" << typeName << ") " << std::endl;
+        CYBR_LOG(warning, plugin, "Plugin not found: " << name << " (" << typeName << ") ");
         return nullptr;
     }
 
@@ -920,7 +1043,7 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
                 insertPoint = i;
                 break;
             }
-            if (checkPlugin->state.hasProperty("cybr-width")) {
+            if (auto x = dynamic_cast<CybrWidthPlugin*>(checkPlugin)) {
                 insertPoint = i;
                 break;
             }
@@ -952,7 +1075,7 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
     }
 
     if (!track.pluginList.canInsertPlugin()) {
-        std::cout << "Selected track cannot insert plugin: " << name << std::endl;
+        CYBR_LOG(warning, plugin, "Selected track cannot insert plugin: " << name);
         return nullptr;
     }
 
@@ -961,9 +1084,8 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
     String printableType = isExternal ? foundPluginDesc.pluginFormatName : "tracktion";
     te::Plugin::Ptr pluginPtr;
     for(int i = 0; i < numToInsert; i++){
-        std::cout
-            << "Inserting \"" << printableName << "\" (" << printableType << ") "
-            << "into track: \"" << track.getName() << "\" at position:" << insertPoint << std::endl;
+        CYBR_LOG(info, plugin, "Inserting \"" << printableName << "\" (" << printableType << ") "
+            << "into track: \"" << track.getName() << "\" at position:" << insertPoint);
         pluginPtr = track.edit.getPluginCache().createNewPlugin(tracktionPluginType, foundPluginDesc);
         track.pluginList.insertPlugin(pluginPtr, insertPoint, nullptr);
         insertPoint++;
@@ -974,28 +1096,28 @@ te::Plugin* getOrCreatePluginByName(te::Track& track, const String name, const S
     return nullptr;
 }
 
-void renderTrackRegion(File outputFile, te::Track& track, te::EditTimeRange range) {
+bool renderTrackRegion(File outputFile, te::Track& track, te::EditTimeRange range) {
     if (range.getLength() == 0) {
-        std::cout << "Cannot render track region: time range is zero." << std::endl;
-        return;
+        CYBR_LOG(error, render, "Cannot render track region: time range is zero.");
+        return false;
     }
 
     if (!outputFile.hasWriteAccess()) {
-        std::cout << "Cannot render track region: No write access: " << outputFile.getFullPathName() << std::endl;
-        return;
+        CYBR_LOG(error, render, "Cannot render track region: No write access: " << outputFile.getFullPathName());
+        return false;
     }
 
     if (outputFile.exists()) {
         if (!outputFile.deleteFile()) {
-            std::cout << "Cannot render track region: Failed to delete existing file" << std::endl;
-            return;
+            CYBR_LOG(error, render, "Cannot render track region: Failed to delete existing file");
+            return false;
         } else {
-            std::cout << "Overwrite: " << outputFile.getFullPathName() << std::endl;
+            CYBR_LOG(info, render, "Overwrite: " << outputFile.getFullPathName());
         }
     }
 
     String jobTitle = "Render " + track.getName() + " to " + outputFile.getFullPathName();
-    std::cout << jobTitle << std::endl;
+    CYBR_LOG(info, render, jobTitle);
 
     BigInteger tracksToDo;
     {
@@ -1014,11 +1136,11 @@ void renderTrackRegion(File outputFile, te::Track& track, te::EditTimeRange rang
                                               range,
                                               tracksToDo);
     if (success) {
-        std::cout << "Rendered: " << outputFile.getFullPathName() << std::endl;
+        CYBR_LOG(info, render, "Rendered: " << outputFile.getFullPathName());
     } else {
-        std::cout << "Failed to render: " << outputFile.getFullPathName() << std::endl;
-        return;
+        CYBR_LOG(error, render, "Failed to render: " << outputFile.getFullPathName());
     }
+    return success;
 }
 
 
@@ -1049,6 +1171,27 @@ void removeAllPluginAutomationFromTrack(te::Track& track) {
 }
 
 
+bool unpackInt32Blob(const OSCDataView& blob, std::vector<int>& result) {
+    if (blob.size % 4 != 0) return false;
+    const size_t count = blob.size / 4;
+    result.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        result[i] = (int) ByteOrder::bigEndianInt(blob.data + i * 4);
+    }
+    return true;
+}
+
+bool unpackFloat32Blob(const OSCDataView& blob, std::vector<float>& result) {
+    if (blob.size % 4 != 0) return false;
+    const size_t count = blob.size / 4;
+    result.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32 bits = ByteOrder::bigEndianInt(blob.data + i * 4);
+        std::memcpy(&result[i], &bits, sizeof(float));
+    }
+    return true;
+}
+
 void setParamAutomationPoint(te::AutomatableParameter::Ptr param, float paramValue, double timeInWholeNotes, float curveValue, bool isNormalized) {
     if (isNormalized) paramValue = param->valueRange.convertFrom0to1(paramValue);
     te::AutomationCurve curve = param->getCurve();
@@ -1066,3 +1209,54 @@ void setParamAutomationPoint(te::AutomatableParameter::Ptr param, float paramVal
     // at the same time, the undesired one might get removed if (for example)
     // the two automation points had different curve values.
 }
+
+void setParamAutomationCurve(te::AutomatableParameter::Ptr param,
+                             const std::vector<float>& paramValues,
+                             const std::vector<float>& timesInWholeNotes,
+                             const std::vector<float>& curveValues,
+                             bool isNormalized) {
+    const size_t count = paramValues.size();
+    jassert(timesInWholeNotes.size() == count);
+    jassert(curveValues.empty() || curveValues.size() == count);
+    if (!count) return;
+
+    struct Point { double time; float value; float curve; };
+    std::vector<Point> points(count);
+    auto& tempoSequence = param->getEdit().tempoSequence;
+    for (size_t i = 0; i < count; i++) {
+        points[i].time = tempoSequence.beatsToTime(timesInWholeNotes[i] * 4.0);
+        points[i].value = isNormalized ? param->valueRange.convertFrom0to1(paramValues[i]) : paramValues[i];
+        points[i].curve = curveValues.empty() ? 0.f : curveValues[i];
+    }
+    // Stable, so that points at the same time keep the order they were sent in
+    std::stable_sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+        return a.time < b.time;
+    });
+
+    // Adding the first point with addPoint ensures the curve's state exists.
+    te::AutomationCurve& curve = param->getCurve();
+    curve.addPoint(points[0].time, points[0].value, points[0].curve);
+
+    // Merge the remaining points with the existing ones. Like addPoint, a new
+    // point goes after any existing points at the same time.
+    ValueTree merged(curve.state.getType());
+    merged.copyPropertiesFrom(curve.state, nullptr);
+    const int numExisting = curve.state.getNumChildren();
+    int existingIndex = 0;
+    for (size_t i = 1; i < count; i++) {
+        while (existingIndex < numExisting
+               && (double)curve.state.getChild(existingIndex)[te::IDs::t] <= points[i].time) {
+            merged.appendChild(curve.state.getChild(existingIndex++).createCopy(), nullptr);
+        }
+        merged.appendChild(ValueTree(te::IDs::POINT, {
+            { te::IDs::t, points[i].time },
+            { te::IDs::v, points[i].value },
+            { te::IDs::c, points[i].curve }
+        }), nullptr);
+    }
+    while (existingIndex < numExisting) {
+        merged.appendChild(curve.state.getChild(existingIndex++).createCopy(), nullptr);
+    }
+
+    curve.state.copyPropertiesAndChildrenFrom(merged, nullptr);
+}
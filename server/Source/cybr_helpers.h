@@ -11,6 +11,10 @@
 #pragma once
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "SamplePathMode.h"
+#include "temp_OSCInputStream.h"
+#include "TrackNameIndex.h"
+#include "KnownPluginIndex.h"
+#include "CybrWidthPlugin.h"
 #include "CybrEdit.h"
 
 namespace te = tracktion_engine;
@@ -18,8 +22,35 @@ namespace te = tracktion_engine;
 /** Create and activate an empty edit */
 te::Edit* createEmptyEdit(juce::File inputFile, te::Engine& engine, te::Edit::EditRole role = te::Edit::forRendering);
 
-/** Load and activate  an edit from a .tracktionedit file */
-te::Edit* createEdit(juce::File inputFile, te::Engine& engine, te::Edit::EditRole role = te::Edit::forRendering);
+/** Load and activate  an edit from a .tracktionedit file. If useSnapshot is
+ true, and a binary snapshot of the file exists that was written from the
+ file's current version, load the snapshot instead of parsing the XML. */
+te::Edit* createEdit(juce::File inputFile, te::Engine& engine, te::Edit::EditRole role = te::Edit::forRendering, bool useSnapshot = false);
+
+/** Get the binary snapshot that sits next to an edit file. For example,
+ song.tracktionedit -> song.tracktionedit.snapshot */
+juce::File getEditSnapshotFile(const juce::File& editFile);
+/** The modification time and size of an edit file. A snapshot stores the
+ stamp of the file it was loaded from. */
+struct EditFileStamp {
+    juce::int64 modifiedMs = 0;
+    juce::int64 size = -1;
+
+    static EditFileStamp of(const juce::File& editFile);
+    bool operator==(const EditFileStamp& other) const { return modifiedMs == other.modifiedMs && size == other.size; }
+};
+/** Returns true if editFile has a snapshot whose stamp matches the file */
+bool hasFreshEditSnapshot(const juce::File& editFile);
+/** Write a gzipped binary ValueTree, with the stamp of the edit file the state
+ was loaded from. Take the stamp before loading the file. Returns true on
+ success. */
+bool writeEditSnapshotBinary(const juce::ValueTree& state, const juce::File& snapshotFile, EditFileStamp stamp);
+/** Read a file written by writeEditSnapshotBinary. Returns an invalid
+ ValueTree if the file is missing or not a snapshot. */
+juce::ValueTree readEditSnapshotBinary(const juce::File& snapshotFile);
+/** A 64 bit hash of a ValueTree's types, properties and children. Trees with
+ the same content have the same fingerprint. */
+juce::uint64 getStateFingerprint(const juce::ValueTree& state);
 
 /** For each audio clip, update that source's filepath. This will use remove and project IDs */
 void setClipAndSamplerSourcesToDirectFileReferences(
@@ -27,6 +58,21 @@ void setClipAndSamplerSourcesToDirectFileReferences(
                                                     SamplePathMode mode = SamplePathMode::decide,
                                                     bool verbose = false);
 
+/** Replace each clip and sampler source in snapshot, a copy of edit's state,
+ with the absolute path found by edit.filePathResolver. Call on the message
+ thread, before passing the snapshot to writeEditSnapshot. */
+void resolveSnapshotSources(juce::ValueTree snapshot, te::Edit& edit);
+
+/** Write an edit's state to a .tracktionedit file. This only reads the
+ ValueTree, so it may be called on a background thread with a snapshot made by
+ state.createCopy() and passed to resolveSnapshotSources. Clip and sampler
+ sources in the snapshot are rewritten according to mode. The file is written
+ to a temporary file, which is then renamed over outputFile. Returns true on
+ success. */
+bool writeEditSnapshot(juce::ValueTree snapshot,
+                       juce::File outputFile,
+                       SamplePathMode mode = SamplePathMode::decide);
+
 /** Try to lookup and add project manager settings from Tracktion Waveform. */
 void autodetectPmSettings(te::Engine& engine);
 void listWaveDevices(te::Engine& engine);
@@ -52,31 +98,66 @@ void removeAllPluginAutomationFromTrack(te::Track& track);
 int ensureBus(te::Edit& edit, juce::String busName);
 
 /** Render a range of the audio file, overwriting the file if it already exists.
-Includes some simple checks like non-zero duration, file write access. */
-void renderTrackRegion(juce::File outputFile, te::Track& track, te::EditTimeRange range);
+Includes some simple checks like non-zero duration, file write access.
+Returns true if the file was rendered. */
+bool renderTrackRegion(juce::File outputFile, te::Track& track, te::EditTimeRange range);
 
 /** Get the submix track by name, creating it if needed. If no parent is
  * specified, create the submix track at the root level. If a parent is
  * specified, search recursively for the parent submix, creating it at the root
- * level if needed.
+ * level if needed. If an index for the edit is supplied, use it instead of
+ * scanning the edit's tracks.
  */
-te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const juce::String name, const juce::String parentName = juce::String());
-te::AudioTrack* getOrCreateAudioTrackByName(te::Edit& edit, const juce::String name, const juce::String parentName = juce::String());
+te::FolderTrack* getOrCreateSubmixByName(te::Edit& edit, const juce::String name, const juce::String parentName = juce::String(), TrackNameIndex* index = nullptr);
+te::AudioTrack* getOrCreateAudioTrackByName(te::Edit& edit, const juce::String name, const juce::String parentName = juce::String(), TrackNameIndex* index = nullptr);
 te::MidiClip* getOrCreateMidiClipByName(te::ClipTrack& track, const juce::String name);
-te::RackType::Ptr ensureWidthRack(te::Track& track);
+
+/** Get the track's cybr-width plugin, creating it before the last volume
+ plugin if needed. A width rack made by an older version is replaced. */
+CybrWidthPlugin* ensureWidthPlugin(te::Track& track);
+/** Get the track's "pan automation" macro, creating it if needed. The macro
+ offsets the pan of the track's last volume plugin, so pan automation and
+ static pan (set on the volume plugin) add together, with the volume plugin's
+ pan law. A macro value of 0.5 is no offset. */
+te::MacroParameter* ensurePanAutomationMacro(te::Track& track);
+/** Replace a track's width rack (and its width macros) with a cybr-width
+ plugin, moving the macro values and automation to the plugin's parameters.
+ The pan automation macro is left as it is. Returns the new plugin, or nullptr
+ if the track has no width rack. */
+CybrWidthPlugin* migrateWidthRack(te::Track& track);
+/** Migrate the width racks on every track. Returns the number migrated. */
+int migrateWidthRacks(te::Edit& edit);
 
 /** Add a plugin just before the VolumeAndPan plugin.
  `type` can be 'vst|vst3|tracktion|AudioUnit' or an empty string.
- If `type` is an empty string, search all types.*/
+ If `type` is an empty string, search all types. If a pluginIndex is
+ supplied, use it instead of walking the known plugin list.*/
 te::Plugin* getOrCreatePluginByName(te::Track& track,
                                     const juce::String name,
                                     const juce::String type = {},
-                                    const int index = 0);
+                                    const int index = 0,
+                                    KnownPluginIndex* pluginIndex = nullptr);
+
+/** Unpack a blob of packed 32 bit values. Like the rest of OSC, the values are
+ expected to be big-endian. Returns false if the blob size is not a multiple
+ of four bytes. */
+bool unpackInt32Blob(const juce::OSCDataView& blob, std::vector<int>& result);
+bool unpackFloat32Blob(const juce::OSCDataView& blob, std::vector<float>& result);
 
 void setParamAutomationPoint(te::AutomatableParameter::Ptr foundParam, float paramValue, double timeInWholeNotes, float curveValue = 0, bool isNormalized = true);
 
+/** Add many automation points to a parameter's curve at once. All the times
+ are converted in a single pass, and the merged point list is written back to
+ the curve in one ValueTree update. `curveValues` may be empty (linear). */
+void setParamAutomationCurve(te::AutomatableParameter::Ptr param,
+                             const std::vector<float>& paramValues,
+                             const std::vector<float>& timesInWholeNotes,
+                             const std::vector<float>& curveValues,
+                             bool isNormalized = true);
+
 class CybrEdit;
 /** Create a copy of a the cybrEdit, suitable for playback and editing.
  CAUTION: The returned CybrEdit should be stored in a unique_ptr to ensure
  it will be deleted correctly. */
 CybrEdit* copyCybrEditForPlayback(CybrEdit& cybrEdit);
+
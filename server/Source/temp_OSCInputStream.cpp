@@ -208,6 +208,212 @@ OSCBundle::Element OSCInputStream::readElementWithKnownSize (size_t elementSize)
     throw OSCFormatError ("OSC input stream: invalid bundle element content");
 }
 
+//==============================================================================
+OSCDataView OSCInputStream::readStringView()
+{
+    checkBytesAvailable (4, "OSC input stream exhausted while reading string");
+
+    auto begin = static_cast<const char*> (getData()) + getPosition();
+    auto bytesRemaining = (size_t) input.getNumBytesRemaining();
+    auto end = static_cast<const char*> (std::memchr (begin, 0, bytesRemaining));
+
+    if (end == nullptr)
+        throw OSCFormatError ("OSC input stream exhausted before finding null terminator of string");
+
+    auto length = (size_t) (end - begin);
+    setPosition ((int64) getPosition() + (int64) length + 1);
+    readPaddingZeros (length + 1);
+
+    return { begin, length };
+}
+
+OSCDataView OSCInputStream::readBlobView()
+{
+    checkBytesAvailable (4, "OSC input stream exhausted while reading blob");
+
+    auto blobDataSize = input.readIntBigEndian();
+
+    if (blobDataSize < 0)
+        throw OSCFormatError ("OSC input stream format error: invalid blob size");
+
+    checkBytesAvailable (blobDataSize, "OSC input stream exhausted before reaching end of blob");
+
+    auto begin = static_cast<const char*> (getData()) + getPosition();
+    setPosition ((int64) getPosition() + blobDataSize);
+    readPaddingZeros ((size_t) blobDataSize);
+
+    return { begin, (size_t) blobDataSize };
+}
+
+OSCArgumentView OSCInputStream::readArgumentView (OSCType type)
+{
+    OSCArgumentView arg;
+    arg.type = type;
+
+    switch (type)
+    {
+        case TypeWrapper::int32:       arg.intValue = readInt32(); break;
+        case TypeWrapper::float32:     arg.floatValue = readFloat32(); break;
+        case TypeWrapper::string:      arg.data = readStringView(); break;
+        case TypeWrapper::blob:        arg.data = readBlobView(); break;
+        case TypeWrapper::colour:      arg.intValue = readInt32(); break;
+
+        default:
+            // You supplied an invalid OSCType when calling readArgumentView! This should never happen.
+            jassertfalse;
+            throw OSCInternalError ("OSC input stream: internal error while reading message argument");
+    }
+
+    return arg;
+}
+
+OSCMessageView OSCInputStream::readMessageView()
+{
+    OSCMessageView msg;
+    msg.address = readStringView();
+
+    if (msg.address.size == 0 || msg.address.data[0] != '/')
+        throw OSCFormatError ("OSC input stream format error: address pattern must start with '/'");
+
+    auto types = readTypeTagString();
+    msg.arguments.reserve ((size_t) types.size());
+
+    for (auto& type : types)
+        msg.arguments.push_back (readArgumentView (type));
+
+    return msg;
+}
+
+OSCElementView OSCInputStream::readBundleView (size_t maxBytesToRead)
+{
+    checkBytesAvailable (16, "OSC input stream exhausted while reading bundle");
+
+    if (readStringView() != "#bundle")
+        throw OSCFormatError ("OSC input stream format error: bundle does not start with string '#bundle'");
+
+    readTimeTag(); // cybr handles bundles immediately, so the time tag is unused
+
+    OSCElementView bundle;
+    bundle.isBundle = true;
+
+    size_t bytesRead = 16; // already read "#bundle" and timeTag
+    auto pos = getPosition();
+
+    while (! isExhausted() && bytesRead < maxBytesToRead)
+    {
+        bundle.elements.push_back (readElementView());
+
+        auto newPos = getPosition();
+        bytesRead += (size_t) (newPos - pos);
+        pos = newPos;
+    }
+
+    return bundle;
+}
+
+OSCElementView OSCInputStream::readElementView()
+{
+    checkBytesAvailable (4, "OSC input stream exhausted while reading bundle element size");
+
+    auto elementSize = (size_t) readInt32();
+
+    if (elementSize < 4)
+        throw OSCFormatError ("OSC input stream format error: invalid bundle element size");
+
+    return readElementViewWithKnownSize (elementSize);
+}
+
+OSCElementView OSCInputStream::readElementViewWithKnownSize (size_t elementSize)
+{
+    checkBytesAvailable ((int64) elementSize, "OSC input stream exhausted while reading bundle element content");
+
+    auto begin = (size_t) getPosition();
+    auto firstContentChar = static_cast<const char*> (getData()) [begin];
+    OSCElementView element;
+
+    if (firstContentChar == '/')
+        element.message = readMessageView();
+    else if (firstContentChar == '#')
+        element = readBundleView (elementSize - 4); // we've already read 4 bytes (the bundle size)
+    else
+        throw OSCFormatError ("OSC input stream: invalid bundle element content");
+
+    if (getPosition() - begin != elementSize)
+        throw OSCFormatError ("OSC input stream format error: wrong element content size encountered while reading");
+
+    return element;
+}
+
+//==============================================================================
+OSCArgument OSCArgumentView::toArgument() const
+{
+    switch (type)
+    {
+        case TypeWrapper::int32:       return OSCArgument (intValue);
+        case TypeWrapper::float32:     return OSCArgument (floatValue);
+        case TypeWrapper::string:      return OSCArgument (data.toString());
+        case TypeWrapper::blob:        return OSCArgument (data.toMemoryBlock());
+        case TypeWrapper::colour:      return OSCArgument (OSCColour::fromInt32 ((uint32) intValue));
+
+        default:
+            jassertfalse;
+            throw OSCInternalError ("OSC argument view: internal error while copying argument");
+    }
+}
+
+OSCMessage OSCMessageView::toMessage() const
+{
+    OSCMessage msg { OSCAddressPattern (address.toString()) };
+
+    for (auto& arg : arguments)
+        msg.addArgument (arg.toArgument());
+
+    return msg;
+}
+
+OSCMessageView OSCMessageView::of (const OSCMessage& message)
+{
+    // juce::String is reference counted, so the copies returned by toString()
+    // and getString() share their character data with the message.
+    auto rawView = [] (const String& s) -> OSCDataView
+    {
+        return { s.toRawUTF8(), s.getNumBytesAsUTF8() };
+    };
+
+    OSCMessageView view;
+    view.address = rawView (message.getAddressPattern().toString());
+    view.arguments.reserve ((size_t) message.size());
+
+    for (auto& arg : message)
+    {
+        OSCArgumentView argView;
+        argView.type = arg.getType();
+
+        if (arg.isInt32())          argView.intValue = arg.getInt32();
+        else if (arg.isFloat32())   argView.floatValue = arg.getFloat32();
+        else if (arg.isString())    argView.data = rawView (arg.getString());
+        else if (arg.isColour())    argView.intValue = (int32) arg.getColour().toInt32();
+        else if (arg.isBlob())      argView.data = { static_cast<const char*> (arg.getBlob().getData()), arg.getBlob().getSize() };
+
+        view.arguments.push_back (argView);
+    }
+
+    return view;
+}
+
+OSCBundle::Element OSCElementView::toElement() const
+{
+    if (! isBundle)
+        return OSCBundle::Element (message.toMessage());
+
+    OSCBundle bundle;
+
+    for (auto& element : elements)
+        bundle.addElement (element.toElement());
+
+    return OSCBundle::Element (bundle);
+}
+
 //==============================================================================
 void OSCInputStream::readPaddingZeros (size_t bytesRead)
 {
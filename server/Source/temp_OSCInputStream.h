@@ -5,10 +5,89 @@
 //  Created by Zhi Wei Gan on 2/24/20.
 //
 
+#pragma once
+
 #include "../JuceLibraryCode/JuceHeader.h"
 
 namespace juce{
 
+//==============================================================================
+/** Points at the content of a string or blob argument inside the data that
+    was decoded, without copying it. Only valid while that data exists.
+*/
+struct OSCDataView
+{
+    const char* data = nullptr;
+    size_t size = 0;
+
+    String toString() const                 { return String::fromUTF8 (data, (int) size); }
+    MemoryBlock toMemoryBlock() const       { return MemoryBlock (data, size); }
+    bool operator== (const char* s) const   { return std::strlen (s) == size && std::memcmp (data, s, size) == 0; }
+    bool operator!= (const char* s) const   { return ! operator== (s); }
+};
+
+//==============================================================================
+/** An OSC argument whose string or blob content is an OSCDataView. The
+    accessors mirror OSCArgument, except that getString() copies the string and
+    getBlob() does not copy the blob.
+*/
+struct OSCArgumentView
+{
+    OSCType type = OSCTypes::int32;
+    int32 intValue = 0;   // int32 and colour
+    float floatValue = 0;
+    OSCDataView data;     // string and blob
+
+    bool isInt32() const noexcept           { return type == OSCTypes::int32; }
+    bool isFloat32() const noexcept         { return type == OSCTypes::float32; }
+    bool isString() const noexcept          { return type == OSCTypes::string; }
+    bool isBlob() const noexcept            { return type == OSCTypes::blob; }
+    bool isColour() const noexcept          { return type == OSCTypes::colour; }
+
+    int32 getInt32() const noexcept         { return intValue; }
+    float getFloat32() const noexcept       { return floatValue; }
+    String getString() const                { return data.toString(); }
+    const OSCDataView& getStringView() const{ return data; }
+    const OSCDataView& getBlob() const      { return data; }
+
+    OSCArgument toArgument() const;
+};
+
+//==============================================================================
+/** A decoded OSC message that refers to the decoded data instead of copying
+    its address, strings and blobs.
+*/
+struct OSCMessageView
+{
+    OSCDataView address;
+    std::vector<OSCArgumentView> arguments;
+
+    int size() const noexcept                                   { return (int) arguments.size(); }
+    const OSCArgumentView& operator[] (int index) const         { return arguments[(size_t) index]; }
+    /** Trailing slashes are trimmed, like OSCAddressPattern does */
+    String getAddress() const                                   { return address.toString().trimCharactersAtEnd ("/"); }
+
+    /** Copy everything into an OSCMessage. Throws OSCFormatError if the
+        address is not a valid address pattern. */
+    OSCMessage toMessage() const;
+
+    /** Create a view of an existing message. The view refers to the message's
+        own storage, so the message must outlive it. */
+    static OSCMessageView of (const OSCMessage& message);
+};
+
+//==============================================================================
+/** A decoded bundle element: either a message, or a bundle of elements */
+struct OSCElementView
+{
+    bool isBundle = false;
+    OSCMessageView message;
+    std::vector<OSCElementView> elements;
+
+    /** Copy everything into an OSCBundle::Element */
+    OSCBundle::Element toElement() const;
+};
+
 //==============================================================================
 /** Allows a block of data to be accessed as a stream of OSC data.
 
@@ -82,6 +161,23 @@ public:
 
     OSCBundle::Element readElementWithKnownSize (size_t elementSize);
 
+    //==============================================================================
+    /** These read like the methods above, but return views into the source
+        data. Nothing is copied, so the source data must outlive the views. */
+    OSCDataView readStringView();
+
+    OSCDataView readBlobView();
+
+    OSCArgumentView readArgumentView (OSCType type);
+
+    OSCMessageView readMessageView();
+
+    OSCElementView readBundleView (size_t maxBytesToRead = std::numeric_limits<size_t>::max());
+
+    OSCElementView readElementView();
+
+    OSCElementView readElementViewWithKnownSize (size_t elementSize);
+
 private:
     MemoryInputStream input;
 
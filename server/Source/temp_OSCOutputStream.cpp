@@ -202,6 +202,47 @@ bool OSCOutputStream::writeBundleElement (const OSCBundle::Element& element)
              && output.setPosition (endPos);
 }
 
+//==============================================================================
+namespace
+{
+    size_t getPaddedStringSize (size_t numBytesAsUTF8)  { return (numBytesAsUTF8 + 4) & ~(size_t) 3; }
+    size_t getPaddedBlobSize (size_t blobSize)          { return 4 + ((blobSize + 3) & ~(size_t) 3); }
+}
+
+size_t OSCOutputStream::getEncodedSize (const OSCMessage& msg)
+{
+    size_t size = getPaddedStringSize (msg.getAddressPattern().toString().getNumBytesAsUTF8());
+    size += ((size_t) msg.size() + 2 + 3) & ~(size_t) 3; // type tag string
+
+    for (auto& arg : msg)
+    {
+        switch (arg.getType())
+        {
+            case TypeWrapper::string:  size += getPaddedStringSize (arg.getString().getNumBytesAsUTF8()); break;
+            case TypeWrapper::blob:    size += getPaddedBlobSize (arg.getBlob().getSize()); break;
+            default:                   size += 4; break;
+        }
+    }
+
+    return size;
+}
+
+size_t OSCOutputStream::getEncodedSize (const OSCBundle& bundle)
+{
+    size_t size = 16; // "#bundle" and time tag
+
+    for (auto& element : bundle)
+        size += 4 + getEncodedSize (element);
+
+    return size;
+}
+
+size_t OSCOutputStream::getEncodedSize (const OSCBundle::Element& element)
+{
+    return element.isBundle() ? getEncodedSize (element.getBundle())
+                              : getEncodedSize (element.getMessage());
+}
+
 //==============================================================================
 //==============================================================================
 #if JUCE_UNIT_TESTS
@@ -24,6 +24,8 @@
   ==============================================================================
 */
 
+#pragma once
+
 #include "../JuceLibraryCode/JuceHeader.h"
 
 namespace juce
@@ -42,6 +44,13 @@ struct JUCE_API OSCOutputStream
 {
     OSCOutputStream() noexcept {}
 
+    /** Creates a stream that writes into a fixed size buffer owned by the
+        caller. Writes fail if they would go past the end of the buffer. Use
+        getEncodedSize to find the size that is needed.
+    */
+    OSCOutputStream (void* destBuffer, size_t destBufferSize) noexcept
+        : output (destBuffer, destBufferSize) {}
+
     /** Returns a pointer to the data that has been written to the stream. */
     const void* getData() const noexcept    { return output.getData(); }
 
@@ -79,6 +88,15 @@ struct JUCE_API OSCOutputStream
     //==============================================================================
     bool writeBundleElement (const OSCBundle::Element& element);
 
+    //==============================================================================
+    /** Returns the number of bytes that writeMessage, writeBundle or
+        writeBundleElement's content will write, without writing anything. */
+    static size_t getEncodedSize (const OSCMessage& msg);
+
+    static size_t getEncodedSize (const OSCBundle& bundle);
+
+    static size_t getEncodedSize (const OSCBundle::Element& element);
+
 private:
     MemoryOutputStream output;
 